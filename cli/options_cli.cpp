@@ -54,6 +54,21 @@ static void options_parse_tc_gomocup(const char *s, EngineOptions &eo)
     eo.increment    = (int64_t)(increment * 1000);
 }
 
+// What is done with a kind of thinking output: "parse", "log" (when allowed) or "drop"
+static OutputMode options_parse_output_mode(const char *s, bool allowLog)
+{
+    OutputMode mode = OUTPUT_PARSE;
+
+    if (!strcmp(s, "log") && allowLog)
+        mode = OUTPUT_LOG;
+    else if (!strcmp(s, "drop"))
+        mode = OUTPUT_DROP;
+    else if (strcmp(s, "parse"))
+        DIE("Invalid output mode '%s'\n", s);
+
+    return mode;
+}
+
 static int options_parse_eo(int argc, const char **argv, int i, EngineOptions &eo)
 {
     while (i < argc && argv[i][0] != '-') {
@@ -83,6 +98,18 @@ static int options_parse_eo(int argc, const char **argv, int i, EngineOptions &e
         else if ((tail = string_prefix(argv[i], "tolerance="))) {
             eo.tolerance = (int64_t)(atof(tail) * 1000);
         }
+        else if ((tail = string_prefix(argv[i], "outlines="))) {
+            eo.output.lines = atoi(tail);
+        }
+        else if ((tail = string_prefix(argv[i], "outbytes="))) {
+            eo.output.bytes = atoll(tail);
+        }
+        else if ((tail = string_prefix(argv[i], "outmessage="))) {
+            eo.output.message = options_parse_output_mode(tail, true);
+        }
+        else if ((tail = string_prefix(argv[i], "outplain="))) {
+            eo.output.plain = options_parse_output_mode(tail, false);
+        }
         else if ((tail = string_prefix(argv[i], "option."))) {
             eo.options.push_back(tail);  // store "name=value" string
         }
@@ -167,6 +194,101 @@ static int options_parse_sprt(int argc, const char **argv, int i, Options &o)
     return i - 1;
 }
 
+static int options_parse_vcf(int argc, const char **argv, int i, Options &o)
+{
+    while (i < argc && argv[i][0] != '-') {
+        const char *tail = NULL;
+
+        if ((tail = string_prefix(argv[i], "nodes=")))
+            o.vcf.nodes = atoll(tail);
+        else if ((tail = string_prefix(argv[i], "time=")))
+            o.vcf.time = atoll(tail);
+        else if ((tail = string_prefix(argv[i], "depth=")))
+            o.vcf.depth = atoi(tail);
+        else
+            DIE("Illegal token in -vcf: '%s'\n", argv[i]);
+
+        i++;
+    }
+
+    if (o.vcf.nodes <= 0 || o.vcf.depth <= 0)
+        DIE("-vcf needs positive nodes and depth\n");
+
+    return i - 1;
+}
+
+static int options_parse_consensus(int argc, const char **argv, int i, Options &o)
+{
+    while (i < argc && argv[i][0] != '-') {
+        const char *tail = NULL;
+
+        if ((tail = string_prefix(argv[i], "count=")))
+            o.consensus.count = atoi(tail);
+        else if ((tail = string_prefix(argv[i], "mate=")))
+            o.consensus.mate = atoi(tail);
+        else if ((tail = string_prefix(argv[i], "score=")))
+            o.consensus.score = atoi(tail);
+        else
+            DIE("Illegal token in -consensus: '%s'\n", argv[i]);
+
+        i++;
+    }
+
+    if (o.consensus.count <= 0 || o.consensus.mate < 0 || o.consensus.score < 0)
+        DIE("-consensus needs a positive count, mate and score can not be negative\n");
+
+    return i - 1;
+}
+
+static int options_parse_solved(int argc, const char **argv, int i, Options &o)
+{
+    while (i < argc && argv[i][0] != '-') {
+        const char *tail = NULL;
+
+        if ((tail = string_prefix(argv[i], "size=")))
+            o.solved.sizeMB = atoll(tail);
+        else if ((tail = string_prefix(argv[i], "plies=")))
+            o.solved.plies = atoi(tail);
+        else
+            DIE("Illegal token in -solved: '%s'\n", argv[i]);
+
+        i++;
+    }
+
+    if (!o.solved.sizeMB || o.solved.plies < 0)
+        DIE("-solved needs a positive size, and plies can not be negative\n");
+
+    // Only the position before a five is proven: the earlier ones are stored as won
+    // because the loser played into the five, and later games are adjudicated on that
+    if (o.solved.plies > 1)
+        std::cerr << "Warning: -solved plies=" << o.solved.plies
+                  << " trusts engine play: positions more than 1 ply before a five are "
+                     "not proven\n";
+
+    return i - 1;
+}
+
+static int options_parse_pool(int argc, const char **argv, int i, Options &o)
+{
+    while (i < argc && argv[i][0] != '-') {
+        const char *tail = NULL;
+
+        if ((tail = string_prefix(argv[i], "idle=")))
+            o.pool.idle = atoi(tail);
+        else if ((tail = string_prefix(argv[i], "mem=")))
+            o.pool.memoryMB = atoll(tail);
+        else
+            DIE("Illegal token in -pool: '%s'\n", argv[i]);
+
+        i++;
+    }
+
+    if (o.pool.idle <= 0)
+        DIE("-pool needs a positive idle count\n");
+
+    return i - 1;
+}
+
 static int options_parse_sample(int argc, const char **argv, int i, Options &o)
 {
     while (i < argc && argv[i][0] != '-') {
@@ -194,12 +316,17 @@ static int options_parse_sample(int argc, const char **argv, int i, Options &o)
             else
                 DIE("Illegal format in -sample: '%s'\n", tail);
         }
+        else if ((tail = string_prefix(argv[i], "features=")))
+            o.sp.features = atoi(tail) != 0;
         else
             DIE("Illegal token in -sample: '%s'\n", argv[i]);
 
         i++;
     }
 
+    if (o.sp.features && o.sp.format != SAMPLE_FORMAT_CSV)
+        DIE("Sample features are only written in the csv format\n");
+
     if (o.sp.fileName.empty()) {
         o.sp.fileName = "sample.";
         if (o.sp.format == SAMPLE_FORMAT_CSV)
@@ -248,6 +375,8 @@ void options_parse(int                         argc,
             o.log = true;
         else if (!strcmp(argv[i], "-concurrency"))
             o.concurrency = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-threads"))
+            o.threads = atoi(argv[++i]);
         else if (!strcmp(argv[i], "-each")) {
             i       = options_parse_eo(argc, argv, i + 1, each);
             eachSet = true;
@@ -269,6 +398,8 @@ void options_parse(int                         argc,
             o.sgf = argv[++i];
         else if (!strcmp(argv[i], "-msg"))
             o.msg = argv[++i];
+        else if (!strcmp(argv[i], "-aboutcache"))
+            o.aboutCache = argv[++i];
         else if (!strcmp(argv[i], "-resign"))
             i = options_parse_adjudication(argc,
                                            argv,
@@ -279,6 +410,14 @@ void options_parse(int                         argc,
             i = options_parse_adjudication(argc, argv, i + 1, &o.drawCount, &o.drawScore);
         else if (!strcmp(argv[i], "-drawafter"))
             o.forceDrawAfter = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-vcf"))
+            i = options_parse_vcf(argc, argv, i + 1, o);
+        else if (!strcmp(argv[i], "-consensus"))
+            i = options_parse_consensus(argc, argv, i + 1, o);
+        else if (!strcmp(argv[i], "-solved"))
+            i = options_parse_solved(argc, argv, i + 1, o);
+        else if (!strcmp(argv[i], "-pool"))
+            i = options_parse_pool(argc, argv, i + 1, o);
         else if (!strcmp(argv[i], "-sprt"))
             i = options_parse_sprt(argc, argv, i + 1, o);
         else if (!strcmp(argv[i], "-sample"))
@@ -302,6 +441,8 @@ void options_parse(int                         argc,
             o.useTURN = false;
         else if (!strcmp(argv[i], "-fatalerror"))
             o.fatalError = true;
+        else if (!strcmp(argv[i], "-rulecheck"))
+            o.ruleCheck = true;
         else {
             DIE("Unknown option '%s'\n", argv[i]);
         }
@@ -341,6 +482,18 @@ void options_parse(int                         argc,
 
             if (each.tolerance)
                 eo[i].tolerance = each.tolerance;
+
+            if (each.output.lines)
+                eo[i].output.lines = each.output.lines;
+
+            if (each.output.bytes)
+                eo[i].output.bytes = each.output.bytes;
+
+            if (each.output.message != OUTPUT_PARSE)
+                eo[i].output.message = each.output.message;
+
+            if (each.output.plain != OUTPUT_PARSE)
+                eo[i].output.plain = each.output.plain;
         }
     }
 
@@ -372,6 +525,15 @@ void options_print(const Options &o, const std::vector<EngineOptions> &eo)
         }
     };
 
+    auto outputModeName = [](OutputMode mode) {
+        switch (mode) {
+        case OUTPUT_PARSE: return "parse";
+        case OUTPUT_LOG: return "log";
+        case OUTPUT_DROP: return "drop";
+        default: return "";
+        }
+    };
+
     std::cout << "---------------------------" << std::endl;
     std::cout << "Global Options:" << std::endl;
     std::cout << "openings = " << o.openings << std::endl;
@@ -382,12 +544,14 @@ void options_print(const Options &o, const std::vector<EngineOptions> &eo)
     std::cout << "pgn = " << o.pgn << std::endl;
     std::cout << "sgf = " << o.sgf << std::endl;
     std::cout << "msg = " << o.msg << std::endl;
+    std::cout << "aboutcache = " << o.aboutCache << std::endl;
     std::cout << "log = " << o.log << std::endl;
     std::cout << "sample = " << o.sp.fileName << std::endl;
     if (!o.sp.fileName.empty()) {
         std::cout << "sample.format = " << sampleFormatName(o.sp.format) << std::endl;
         std::cout << "sample.compress = " << o.sp.compress << std::endl;
         std::cout << "sample.freq = " << o.sp.freq << std::endl;
+        std::cout << "sample.features = " << o.sp.features << std::endl;
     }
     std::cout << "random = " << o.random << std::endl;
     std::cout << "repeat = " << o.repeat << std::endl;
@@ -397,6 +561,7 @@ void options_print(const Options &o, const std::vector<EngineOptions> &eo)
     if (o.gauntlet)
         std::cout << "loseonly = " << o.saveLoseOnly << std::endl;
     std::cout << "concurrency = " << o.concurrency << std::endl;
+    std::cout << "threads = " << o.threads << std::endl;
     std::cout << "games = " << o.games << std::endl;
     std::cout << "rounds = " << o.rounds << std::endl;
     std::cout << "resignCount = " << o.resignCount << std::endl;
@@ -404,8 +569,25 @@ void options_print(const Options &o, const std::vector<EngineOptions> &eo)
     std::cout << "drawCount = " << o.drawCount << std::endl;
     std::cout << "drawScore = " << o.drawScore << std::endl;
     std::cout << "drawAfter = " << o.forceDrawAfter << std::endl;
+    std::cout << "vcf.nodes = " << o.vcf.nodes << std::endl;
+    if (o.vcf.nodes) {
+        std::cout << "vcf.time = " << o.vcf.time << std::endl;
+        std::cout << "vcf.depth = " << o.vcf.depth << std::endl;
+    }
+    std::cout << "consensus.count = " << o.consensus.count << std::endl;
+    if (o.consensus.count) {
+        std::cout << "consensus.mate = " << o.consensus.mate << std::endl;
+        std::cout << "consensus.score = " << o.consensus.score << std::endl;
+    }
+    std::cout << "solved.size = " << o.solved.sizeMB << std::endl;
+    if (o.solved.sizeMB)
+        std::cout << "solved.plies = " << o.solved.plies << std::endl;
+    std::cout << "pool.idle = " << o.pool.idle << std::endl;
+    if (o.pool.idle)
+        std::cout << "pool.mem = " << o.pool.memoryMB << std::endl;
     std::cout << "fatalerror = " << o.fatalError << std::endl;
     std::cout << "debug = " << o.debug << std::endl;
+    std::cout << "rulecheck = " << o.ruleCheck << std::endl;
     std::cout << std::endl;
 
     size_t engineCnt = eo.size();
@@ -424,6 +606,10 @@ void options_print(const Options &o, const std::vector<EngineOptions> &eo)
         std::cout << "maxMemory = " << e1.maxMemory << std::endl;
         std::cout << "thread = " << e1.numThreads << std::endl;
         std::cout << "tolerance = " << e1.tolerance << std::endl;
+        std::cout << "outlines = " << e1.output.lines << std::endl;
+        std::cout << "outbytes = " << e1.output.bytes << std::endl;
+        std::cout << "outmessage = " << outputModeName(e1.output.message) << std::endl;
+        std::cout << "outplain = " << outputModeName(e1.output.plain) << std::endl;
         for (size_t i = 0; i < e1.options.size(); i++) {
             std::cout << "option." << e1.options[i] << std::endl;
         }
@@ -1,8 +1,10 @@
 #include "TournamentManager.h"
 #include "position.h"
+#include "reactor.h"
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <set>
 
 // Compression preference for binary samples
 static const LZ4F_preferences_t LZ4Pref = {.frameInfo        = {},
@@ -12,7 +14,7 @@ static const LZ4F_preferences_t LZ4Pref = {.frameInfo        = {},
                                             .reserved         = {}};
 
 TournamentManager::TournamentManager()
-    : openings(nullptr), jq(nullptr), pgnSeqWriter(nullptr), sgfSeqWriter(nullptr), msgSeqWriter(nullptr), sampleFile(nullptr), initialized(false), running(false)
+    : openings(nullptr), jq(nullptr), pgnSeqWriter(nullptr), sgfSeqWriter(nullptr), msgSeqWriter(nullptr), solvedCache(nullptr), enginePool(nullptr), aboutCache(nullptr), sampleFile(nullptr), initialized(false), running(false)
 {
 }
 
@@ -40,6 +42,15 @@ void TournamentManager::init(const Options &opts, const std::vector<EngineOption
     if (!options.msg.empty())
         msgSeqWriter = new SeqWriter(options.msg.c_str(), "a" FOPEN_TEXT);
 
+    if (options.solved.sizeMB)
+        solvedCache = new SolvedCache(options.solved.sizeMB);
+
+    if (!options.aboutCache.empty())
+        aboutCache = new AboutCache(options.aboutCache.c_str());
+
+    enginePool = new EnginePool(eo, options.pool, aboutCache, options.debug);
+    outputStats.assign(eo.size(), OutputStats());
+
     if (!options.sp.fileName.empty()) {
         if (options.sp.compress) {
             DIE_IF(0,
@@ -81,12 +92,85 @@ void TournamentManager::start()
     if (!initialized) return;
     if (running) return;
 
+    if (aboutCache)
+        probe_engines();
+
+#ifdef __linux__
+    // With fewer threads than games, each thread runs its share of the workers as
+    // reactor tasks, which wait for all their engines at once
+    if (options.threads > 0 && options.threads < options.concurrency) {
+        for (int t = 0; t < options.threads; t++) {
+            threads.emplace_back([this, t] {
+                Reactor reactor;
+                for (int i = t; i < options.concurrency; i += options.threads)
+                    reactor.spawn([this, i] { thread_start(workers[i]); });
+                reactor.run();
+            });
+        }
+        running = true;
+        return;
+    }
+#endif
+
     for (int i = 0; i < options.concurrency; i++) {
         threads.emplace_back(&TournamentManager::thread_start, this, workers[i]);
     }
     running = true;
 }
 
+// Starts every distinct engine whose ABOUT answer is not cached (yet), at once, before
+// the workers: this fills the cache, and a wrong command or a broken engine stops the
+// tournament before any game begins
+void TournamentManager::probe_engines()
+{
+    std::set<std::string>              cmds;
+    std::vector<const EngineOptions *> probes;
+
+    for (const EngineOptions &e : eo) {
+        if (!cmds.insert(e.cmd).second)
+            continue;
+
+        std::string    about;
+        const uint64_t key = aboutCache->key(Engine::binary_path(e.cmd.c_str()), e.cmd);
+        if (!key || !aboutCache->lookup(key, about))
+            probes.push_back(&e);
+    }
+
+    std::vector<std::thread> probeThreads;
+    for (const EngineOptions *e : probes) {
+        probeThreads.emplace_back([this, e] {
+            Worker worker(-1, "");  // id 0, as the main thread
+            Engine engine(&worker, options.debug, nullptr);
+            engine.aboutCache = aboutCache;
+            engine.start(e->cmd.c_str(), e->name.c_str(), e->tolerance);
+            engine.terminate();
+        });
+    }
+
+    for (std::thread &th : probeThreads)
+        th.join();
+}
+
+// Engines whose output went beyond their budget
+std::string TournamentManager::output_stats()
+{
+    std::string      out;
+    std::scoped_lock lock(outputMtx, jq->mtx);
+
+    for (size_t i = 0; i < outputStats.size(); i++) {
+        const OutputStats &s = outputStats[i];
+        if (s.dropped || s.droppedBytes)
+            out += format("Output of %s: %" PRIu64 " of %" PRIu64
+                          " lines dropped, %" PRIu64 " message bytes dropped\n",
+                          jq->names[i],
+                          s.dropped,
+                          s.lines,
+                          s.droppedBytes);
+    }
+
+    return out;
+}
+
 void TournamentManager::stop()
 {
     if (!running) return;
@@ -98,9 +182,9 @@ void TournamentManager::stop()
     if (jq) jq->stop();
     
     // 3. Force-terminate engine processes to unblock any blocking reads.
-    //    Worker threads are stuck in Engine::readln() -> fgets() waiting for
-    //    engine output. Killing the engine process closes the pipe, causing
-    //    fgets() to return NULL (EOF), which unblocks the thread.
+    //    Worker threads may be polling in Engine::readln() for engine output.
+    //    Killing the engine process closes the pipe, causing the read to
+    //    return EOF, which unblocks the thread.
     //    We access workers directly since they are only freed in this method.
     for (auto* worker : workers) {
         // Fire the deadline callback if set — this calls engine.terminate(true)
@@ -117,6 +201,14 @@ void TournamentManager::stop()
     }
     threads.clear();
 
+    // Idle engines are terminated by the main thread, on behalf of the first worker
+    if (enginePool) {
+        enginePool->clear(workers[0]);
+        delete enginePool;
+        enginePool = nullptr;
+    }
+    if (aboutCache) { delete aboutCache; aboutCache = nullptr; }
+
     for (Worker *worker : workers)
         delete worker;
     workers.clear();
@@ -126,6 +218,7 @@ void TournamentManager::stop()
     if (pgnSeqWriter) { delete pgnSeqWriter; pgnSeqWriter = nullptr; }
     if (sgfSeqWriter) { delete sgfSeqWriter; sgfSeqWriter = nullptr; }
     if (msgSeqWriter) { delete msgSeqWriter; msgSeqWriter = nullptr; }
+    if (solvedCache) { delete solvedCache; solvedCache = nullptr; }
 
     if (openings) { delete openings; openings = nullptr; }
     if (jq) { delete jq; jq = nullptr; }
@@ -321,19 +414,20 @@ void TournamentManager::updateBoardSnapshot(const Position& pos)
 
 void TournamentManager::thread_start(Worker *w)
 {
-    std::string opening_str, messages;
-    size_t      idx = 0, count = 0;     // game idx and count (shared across workers)
-    Job         job   = {};
-    Engine engines[2] = {{w, options.debug, !options.msg.empty() ? &messages : nullptr},
-                         {w, options.debug, !options.msg.empty() ? &messages : nullptr}};
-    
-    // Set up message forwarding to GUI log and eval handling
-    for (int i = 0; i < 2; i++) {
-        Engine* eng = &engines[i];
-        eng->onMessage = [this, eng](const std::string& msg) {
-            addLog(eng->name + ": " + msg);
+    std::string  opening_str, messages;
+    size_t       idx = 0, count = 0;  // game idx and count (shared across workers)
+    Job          job        = {};
+    Engine      *engines[2] = {nullptr, nullptr};  // borrowed from enginePool
+    std::string *outmsg     = !options.msg.empty() ? &messages : nullptr;
+
+    // Set up message forwarding to GUI log and eval handling, for an engine just
+    // borrowed from the pool
+    auto bind_engine = [this, &idx, &engines](int i) {
+        Engine* eng = engines[i];
+        eng->onMessage = [this, eng](std::string_view msg) {
+            addLog(eng->name + ": " + std::string(msg));
         };
-        eng->onInfo = [this, eng, &job, &idx, &engines](const Info& info, int ply) {
+        eng->onInfo = [this, i, &idx](const Info& info, int ply) {
             // Calculate winrate
             double winrate = 0.5;
             if (abs(info.score) > 20000) { // Mate
@@ -348,14 +442,14 @@ void TournamentManager::thread_start(Worker *w)
                 ei.gameIdx = idx;
                 ei.moveIdx = ply;
                 // Identify engine index (0 or 1) in the current game context
-                ei.engineIdx = (eng == &engines[0]) ? 0 : 1;
+                ei.engineIdx = i;
                 ei.score = info.score;
                 ei.isMate = abs(info.score) > 20000;
                 ei.winrate = winrate;
                 this->onEngineEval(ei);
             }
         };
-    }
+    };
 
     int    ei[2]      = {-1, -1};  // eo[ei[0]] plays eo[ei[1]]: initialize with invalid
                                    // values to start
@@ -389,22 +483,22 @@ void TournamentManager::thread_start(Worker *w)
             messages += format("Game ID: %zu\n", idx + 1);
         }
 
-        // Engine stop/start, as needed
+        // Engine switch (through the pool) or restart, as needed
         for (int i = 0; i < 2; i++) {
             if (job.ei[i] != ei[i]) {
-                ei[i] = job.ei[i];
-                engines[i].terminate();
-                engines[i].start(eo[ei[i]].cmd.c_str(),
-                                 eo[ei[i]].name.c_str(),
-                                 eo[ei[i]].tolerance);
-                jq->set_name(ei[i], engines[i].name);
+                if (engines[i])
+                    enginePool->release(ei[i], engines[i], w);
+                ei[i]      = job.ei[i];
+                engines[i] = enginePool->acquire(ei[i], w, outmsg);
+                bind_engine(i);
+                jq->set_name(ei[i], engines[i]->name);
             }
             // Re-init engine if it crashed/timeout previously
-            else if (!engines[i].is_ok() || engines[i].is_crashed()) {
-                engines[i].terminate();
-                engines[i].start(eo[ei[i]].cmd.c_str(),
-                                 eo[ei[i]].name.c_str(),
-                                 eo[ei[i]].tolerance);
+            else if (!engines[i]->is_ok() || engines[i]->is_crashed()) {
+                engines[i]->terminate();
+                engines[i]->start(eo[ei[i]].cmd.c_str(),
+                                  eo[ei[i]].name.c_str(),
+                                  eo[ei[i]].tolerance);
             }
         }
 
@@ -432,8 +526,8 @@ void TournamentManager::thread_start(Worker *w)
         // Now that the opening is loaded, populate workerGameInfos with correct names
         {
             std::lock_guard<std::mutex> lock(progressMtx);
-            std::string bName = engines[blackIdx].name;
-            std::string wName = engines[whiteIdx].name;
+            std::string bName = engines[blackIdx]->name;
+            std::string wName = engines[whiteIdx]->name;
             workerGameInfos[w->id] = {idx + 1, bName, wName,
                                       eo[ei[blackIdx]].timeoutMatch,
                                       eo[ei[whiteIdx]].timeoutMatch};
@@ -452,25 +546,37 @@ void TournamentManager::thread_start(Worker *w)
         // Allow game loop to exit early when stop is requested
         game.shouldAbort = [this]() { return abortFlag.load(); };
 
+        game.solvedCache = solvedCache;
+
         {
             std::string msg = format("[%d] Started game %zu of %zu (%s vs %s)",
                 w->id,
                 idx + 1,
                 count,
-                engines[blackIdx].name.c_str(),
-                engines[whiteIdx].name.c_str());
+                engines[blackIdx]->name.c_str(),
+                engines[whiteIdx]->name.c_str());
             printf("%s\n", msg.c_str());
             addLog(msg);
         }
 
         if (!options.msg.empty())
             messages += format("Engines: %s x %s\n",
-                               engines[blackIdx].name,
-                               engines[whiteIdx].name);
+                               engines[blackIdx]->name,
+                               engines[whiteIdx]->name);
 
         const EngineOptions *eoPair[2] = {&eo[ei[0]], &eo[ei[1]]};
         const int            wld       = game.play(options, engines, eoPair, job.reverse);
 
+        {
+            std::lock_guard lock(outputMtx);
+            for (int i = 0; i < 2; i++) {
+                const OutputStats played = engines[i]->take_output_stats();
+                outputStats[ei[i]].lines += played.lines;
+                outputStats[ei[i]].dropped += played.dropped;
+                outputStats[ei[i]].droppedBytes += played.droppedBytes;
+            }
+        }
+
         if (!options.gauntlet || !options.saveLoseOnly || wld == RESULT_LOSS) {
             // Write to PGN file
             if (pgnSeqWriter)
@@ -486,7 +592,7 @@ void TournamentManager::thread_start(Worker *w)
 
             // Write to Sample file
             if (sampleFile)
-                game.export_samples(sampleFile, options.sp.format, sampleFileLz4Ctx);
+                game.export_samples(sampleFile, options.sp, sampleFileLz4Ctx);
         }
 
         // Write to stdout a one line summary of the game
@@ -497,8 +603,8 @@ void TournamentManager::thread_start(Worker *w)
         {
             std::string summary = format("Game %zu: %s vs %s: %s {%s}",
                 idx + 1,
-                engines[blackIdx].name.c_str(),
-                engines[whiteIdx].name.c_str(),
+                engines[blackIdx]->name.c_str(),
+                engines[whiteIdx]->name.c_str(),
                 result.c_str(),
                 reason.c_str());
             setLastResult(summary);
@@ -513,8 +619,8 @@ void TournamentManager::thread_start(Worker *w)
             wldCount[RESULT_WIN] + wldCount[RESULT_LOSS] + wldCount[RESULT_DRAW];
         {
             std::string scoreMsg = format("Score of %s vs %s: %d - %d - %d  [%.3f] %d",
-                   engines[0].name.c_str(),
-                   engines[1].name.c_str(),
+                   engines[0]->name.c_str(),
+                   engines[1]->name.c_str(),
                    wldCount[RESULT_WIN],
                    wldCount[RESULT_LOSS],
                    wldCount[RESULT_DRAW],
@@ -530,10 +636,19 @@ void TournamentManager::thread_start(Worker *w)
         }
 
         // Tournament update
-        jq->print_results((size_t)options.games);
+        std::string stats;
+        if (solvedCache)
+            stats += solvedCache->stats();
+        if (options.pool.idle)
+            stats += enginePool->stats();
+        stats += output_stats();
+        jq->print_results((size_t)options.games, stats);
     }
 
+    // Engines left idle may still serve the other workers: they were spawned by a thread
+    // that outlives this one (see Engine::spawn)
     for (int i = 0; i < 2; i++) {
-        engines[i].terminate();
+        if (engines[i])
+            enginePool->release(ei[i], engines[i], w);
     }
 }
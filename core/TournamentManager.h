@@ -1,7 +1,9 @@
 #pragma once
 
 #include "BoardState.h"
+#include "aboutcache.h"
 #include "engine.h"
+#include "enginepool.h"
 #include "extern/lz4frame.h"
 #include "game.h"
 #include "jobs.h"
@@ -86,6 +88,8 @@ public:
 
 private:
     void thread_start(Worker *w);
+    void probe_engines();
+    std::string output_stats();
     void close_sample_file(bool signal_exit);
     void updateBoardSnapshot(const Position& pos);
     void setLastResult(const std::string &result);
@@ -99,6 +103,11 @@ private:
     SeqWriter                 *pgnSeqWriter;
     SeqWriter                 *sgfSeqWriter;
     SeqWriter                 *msgSeqWriter;
+    SolvedCache               *solvedCache;
+    EnginePool                *enginePool;
+    AboutCache                *aboutCache;
+    std::mutex                 outputMtx;
+    std::vector<OutputStats>   outputStats;  // per engine, over the tournament
     std::vector<Worker *>      workers;
     std::vector<std::thread>   threads;
     
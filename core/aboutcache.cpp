@@ -0,0 +1,153 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "aboutcache.h"
+
+#include "extern/xxhash.h"
+#include "util.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <vector>
+
+AboutCache::AboutCache(const char *file) : fileName(file)
+{
+    FILE *in = fopen(fileName.c_str(), "r" FOPEN_TEXT);
+    if (!in)  // nothing cached yet
+        return;
+
+    std::string line;
+    while (string_getline(line, in)) {
+        char          *tail;
+        const uint64_t key = strtoull(line.c_str(), &tail, 16);
+        if (key && *tail == ' ')
+            entries[key] = tail + 1;
+    }
+
+    DIE_IF(0, fclose(in) < 0);
+}
+
+bool AboutCache::hash_binary(const std::string &path, uint64_t &hash)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) < 0)
+        return false;
+
+    {
+        std::lock_guard lock(mtx);
+        auto            it = binaries.find(path);
+        if (it != binaries.end() && it->second.size == (int64_t)st.st_size
+            && it->second.mtime == (int64_t)st.st_mtime) {
+            hash = it->second.hash;
+            return true;
+        }
+    }
+
+    FILE *in = fopen(path.c_str(), "r" FOPEN_BINARY);
+    if (!in)
+        return false;
+
+    // Engine binaries (and their embedded weights) can be large: hash them by chunks
+    std::vector<char> buf(1 << 20);
+    XXH64_state_t    *state = XXH64_createState();
+    XXH64_reset(state, 0);
+    size_t n;
+    while ((n = fread(buf.data(), 1, buf.size(), in)) > 0)
+        XXH64_update(state, buf.data(), n);
+    hash = XXH64_digest(state);
+    XXH64_freeState(state);
+
+    const bool ok = !ferror(in);
+    fclose(in);
+
+    if (ok) {
+        std::lock_guard lock(mtx);
+        binaries[path] = {(int64_t)st.st_size, (int64_t)st.st_mtime, hash};
+    }
+    return ok;
+}
+
+uint64_t AboutCache::key(const std::string &binary, const std::string &cmd)
+{
+    std::string path = binary;
+
+    // Unqualified command: the binary is the one execvp() finds in PATH
+    if (binary.find('/') == std::string::npos) {
+#ifdef __MINGW32__
+        const char *separator = ";";
+#else
+        const char *separator = ":";
+#endif
+        const char *dirs = getenv("PATH");
+        std::string dir;
+        path.clear();
+
+        while (dirs && (dirs = string_tok(dir, dirs, separator))) {
+            struct stat       st;
+            const std::string candidate = dir + "/" + binary;
+            if (stat(candidate.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+                path = candidate;
+                break;
+            }
+        }
+    }
+
+    uint64_t binaryHash;
+    if (path.empty() || !hash_binary(path, binaryHash))
+        return 0;
+
+    // Same binary with other arguments (weights, config) may answer differently
+    const uint64_t k = XXH64(cmd.data(), cmd.size(), binaryHash);
+    return k ? k : 1;  // 0 means not cached
+}
+
+bool AboutCache::lookup(uint64_t key, std::string &about) const
+{
+    std::lock_guard lock(mtx);
+
+    auto it = entries.find(key);
+    if (it == entries.end())
+        return false;
+
+    about = it->second;
+    return true;
+}
+
+void AboutCache::store(uint64_t key, const std::string &about)
+{
+    std::lock_guard lock(mtx);
+
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second == about)
+        return;
+    entries[key] = about;
+
+    // Write a new file and replace the old one, so that a reader never sees half of it
+    const std::string tmpName = fileName + ".tmp";
+    FILE             *out;
+    DIE_IF(0, !(out = fopen(tmpName.c_str(), "w" FOPEN_TEXT)));
+
+    for (const auto &[k, line] : entries)
+        DIE_IF(0, fprintf(out, "%016" PRIx64 " %s\n", k, line.c_str()) < 0);
+
+    DIE_IF(0, fclose(out) < 0);
+#ifdef __MINGW32__
+    remove(fileName.c_str());  // rename() does not replace files on Windows
+#endif
+    DIE_IF(0, rename(tmpName.c_str(), fileName.c_str()) < 0);
+}
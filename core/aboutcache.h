@@ -0,0 +1,55 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Answers of engines to ABOUT, saved in a file across tournaments, so that starting an
+// engine does not wait for the handshake. An entry is keyed by a hash of the engine binary
+// and of its command line: rebuilding the engine, or changing its arguments, makes a new
+// entry. The file has one line per entry: the key in hex, a space, and the ABOUT line.
+class AboutCache
+{
+public:
+    explicit AboutCache(const char *fileName);  // loads the file, if it exists
+
+    // Key of an engine command, 0 when the binary can not be read (not cached). The hash
+    // of a binary is remembered with its size and modification time, so restarting an
+    // engine does not read the binary again.
+    uint64_t key(const std::string &binary, const std::string &cmd);
+
+    bool lookup(uint64_t key, std::string &about) const;
+    void store(uint64_t key, const std::string &about);  // and rewrites the file
+
+private:
+    struct BinaryHash
+    {
+        int64_t  size, mtime;
+        uint64_t hash;
+    };
+
+    const std::string fileName;
+
+    mutable std::mutex                          mtx;
+    std::unordered_map<uint64_t, std::string>   entries;
+    std::unordered_map<std::string, BinaryHash> binaries;  // by path
+
+    bool hash_binary(const std::string &path, uint64_t &hash);
+};
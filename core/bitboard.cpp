@@ -0,0 +1,132 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bitboard.h"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+static_assert(BitBoard::LineCount % 8 == 0, "planes must be a multiple of SIMD width");
+
+void BitBoard::clear()
+{
+    memset(lines, 0, sizeof(lines));
+}
+
+void BitBoard::set(uint16_t pos, int color)
+{
+    assert(color == 0 || color == 1);
+    for (int iDir = 0; iDir < 4; iDir++)
+        lines[color][line_index(pos, iDir)] |= 1u << bit_index(pos, iDir);
+}
+
+void BitBoard::del(uint16_t pos, int color)
+{
+    assert(color == 0 || color == 1);
+    for (int iDir = 0; iDir < 4; iDir++)
+        lines[color][line_index(pos, iDir)] &= ~(1u << bit_index(pos, iDir));
+}
+
+const uint32_t *BitBoard::board_lines(int boardSize)
+{
+    static const int MaxSize = 32 - 2 * 5;  // boards are padded by 5 cells
+
+    static const struct BoardLines
+    {
+        uint32_t lines[MaxSize + 1][LineCount] = {};
+
+        BoardLines()
+        {
+            for (int size = 1; size <= MaxSize; size++)
+                for (int x = 5; x < 5 + size; x++)
+                    for (int y = 5; y < 5 + size; y++)
+                        for (int iDir = 0; iDir < 4; iDir++) {
+                            uint16_t pos = (x << 5) + y;
+                            lines[size][line_index(pos, iDir)] |= 1u << bit_index(pos, iDir);
+                        }
+        }
+    } boardLines;
+
+    assert(boardSize > 0 && boardSize <= MaxSize);
+    return boardLines.lines[boardSize];
+}
+
+template <int Size, bool Exact> bool BitBoard::has_five(int color, int boardSize) const
+{
+    const int n = Size ? Size : boardSize;
+
+    // Lines of each plane that cross a board of size n (the board starts at 5 in the
+    // padded layout). Ranges are widened to whole SIMD words: the extra words are
+    // other lines of the same colour, or empty padding, so they never add a five.
+    const int W        = 8;
+    const int begin[4] = {5, 32 + 10, 95 + 5, 127 + 31 - (n - 1)};
+    const int end[4]   = {5 + n, 32 + 10 + 2 * n - 1, 95 + 5 + n, 127 + 31 + n};
+
+    const uint32_t *b = lines[color];
+
+#if defined(__AVX2__)
+    __m256i any = _mm256_setzero_si256();
+    for (int r = 0; r < 4; r++)
+        for (int i = begin[r] / W * W; i < end[r]; i += 8) {
+            __m256i v = _mm256_load_si256((const __m256i *)(b + i));
+            __m256i f = _mm256_and_si256(v, _mm256_srli_epi32(v, 1));
+            f         = _mm256_and_si256(f, _mm256_srli_epi32(f, 2));
+            f         = _mm256_and_si256(f, _mm256_srli_epi32(v, 4));
+            if (Exact) {
+                f = _mm256_andnot_si256(_mm256_slli_epi32(v, 1), f);
+                f = _mm256_andnot_si256(_mm256_srli_epi32(v, 5), f);
+            }
+            any = _mm256_or_si256(any, f);
+        }
+    return !_mm256_testz_si256(any, any);
+#elif defined(__SSE2__)
+    __m128i any = _mm_setzero_si128();
+    for (int r = 0; r < 4; r++)
+        for (int i = begin[r] / W * W; i < end[r]; i += 4) {
+            __m128i v = _mm_load_si128((const __m128i *)(b + i));
+            __m128i f = _mm_and_si128(v, _mm_srli_epi32(v, 1));
+            f         = _mm_and_si128(f, _mm_srli_epi32(f, 2));
+            f         = _mm_and_si128(f, _mm_srli_epi32(v, 4));
+            if (Exact) {
+                f = _mm_andnot_si128(_mm_slli_epi32(v, 1), f);
+                f = _mm_andnot_si128(_mm_srli_epi32(v, 5), f);
+            }
+            any = _mm_or_si128(any, f);
+        }
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(any, _mm_setzero_si128())) != 0xFFFF;
+#else
+    uint32_t any = 0;
+    for (int r = 0; r < 4; r++)
+        for (int i = begin[r]; i < end[r]; i++)
+            any |= five_starts(b[i], Exact);
+    return any != 0;
+#endif
+}
+
+template bool BitBoard::has_five<0, false>(int, int) const;
+template bool BitBoard::has_five<0, true>(int, int) const;
+template bool BitBoard::has_five<15, false>(int, int) const;
+template bool BitBoard::has_five<15, true>(int, int) const;
+template bool BitBoard::has_five<19, false>(int, int) const;
+template bool BitBoard::has_five<19, true>(int, int) const;
+template bool BitBoard::has_five<20, false>(int, int) const;
+template bool BitBoard::has_five<20, true>(int, int) const;
@@ -0,0 +1,109 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Per-colour line bitboards over the padded 32x32 board layout (see position.h).
+// Each colour owns one plane per direction (same order as DIRECTION[]), and a plane
+// holds every board line along that direction as a 32-bit word:
+//   dir 0 (y+1):      32 lines indexed by x,      bit = y
+//   dir 1 (x+1, y-1): 63 lines indexed by x + y,  bit = x
+//   dir 2 (x+1):      32 lines indexed by y,      bit = x
+//   dir 3 (x+1, y+1): 63 lines indexed by x - y,  bit = x
+// so that moving against the direction always means moving to a lower bit.
+class BitBoard
+{
+public:
+    static const int LineCount = 192;  // 32 + 63 + 32 + 63, padded for SIMD loads
+    static constexpr int FirstLine[5] = {0, 32, 95, 127, 190};  // lines of each plane
+
+    void clear();
+    void set(uint16_t pos, int color);
+    void del(uint16_t pos, int color);
+
+    uint32_t line(int color, uint16_t pos, int iDir) const
+    {
+        return lines[color][line_index(pos, iDir)];
+    }
+    uint32_t line(int color, int li) const { return lines[color][li]; }
+
+    // true if color has five in a row anywhere (exactly five if Exact is set) on a
+    // board of the given size. Only the lines crossing the board are scanned; a
+    // non-zero Size makes the line ranges constants, instantiated for 15, 19 and 20.
+    template <int Size, bool Exact> bool has_five(int color, int boardSize) const;
+
+    static int line_index(uint16_t pos, int iDir)
+    {
+        const int x = pos >> 5, y = pos & 31;
+        switch (iDir) {
+        case 0: return x;
+        case 1: return 32 + x + y;
+        case 2: return 95 + y;
+        default: return 127 + 31 + x - y;
+        }
+    }
+    static int bit_index(uint16_t pos, int iDir) { return iDir ? pos >> 5 : pos & 31; }
+
+    // Inverse of line_index()/bit_index(): the cell at bit k of line li
+    static uint16_t pos_at(int li, int k)
+    {
+        if (li < 32)
+            return (li << 5) + k;
+        else if (li < 95)
+            return (k << 5) + (li - 32 - k);
+        else if (li < 127)
+            return (k << 5) + (li - 95);
+        else
+            return (k << 5) + (k + 158 - li);
+    }
+
+    // Same planes, with a bit set for every cell of a board of the given size
+    static const uint32_t *board_lines(int boardSize);
+
+private:
+    alignas(32) uint32_t lines[2][LineCount];
+};
+
+// Number of consecutive set bits just below bit k (k is in the board, so k > 0)
+inline int run_below(uint32_t b, int k)
+{
+    return __builtin_clz(~(b << (32 - k)));
+}
+
+// Number of consecutive set bits just above bit k (k is in the board, so k < 31)
+inline int run_above(uint32_t b, int k)
+{
+    return __builtin_ctz(~(b >> (k + 1)));
+}
+
+// Length of the run of set bits through bit k, counting bit k itself as set
+inline int run_length(uint32_t b, int k)
+{
+    return 1 + run_below(b, k) + run_above(b, k);
+}
+
+// Marks the lowest bit of every run of five set bits (runs of exactly five if exact)
+inline uint32_t five_starts(uint32_t b, bool exact)
+{
+    uint32_t f = b & (b >> 1);
+    f &= f >> 2;
+    f &= b >> 4;
+    if (exact)
+        f &= ~(b << 1) & ~(b >> 5);
+    return f;
+}
@@ -0,0 +1,192 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "codec.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+CodecResult fail(CodecStatus status, size_t pos)
+{
+    return {status, pos};
+}
+
+// Reads a decimal number at s[i] (optionally negative), and moves i past it
+bool readInt(std::string_view s, size_t &i, int &value)
+{
+    const char *first = s.data() + i, *last = s.data() + s.size();
+    auto [ptr, ec]    = std::from_chars(first, last, value);
+    if (ec != std::errc() || ptr == first)
+        return false;
+    i += ptr - first;
+    return true;
+}
+
+bool isBlank(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Appends an integer at buf[n], keeping room for the final NUL
+bool writeInt(char *buf, size_t size, size_t &n, int value)
+{
+    if (n >= size)
+        return false;
+    auto [ptr, ec] = std::to_chars(buf + n, buf + size - 1, value);
+    if (ec != std::errc())
+        return false;
+    n = ptr - buf;
+    return true;
+}
+
+bool writeChar(char *buf, size_t size, size_t &n, char c)
+{
+    if (n + 1 >= size)
+        return false;
+    buf[n++] = c;
+    return true;
+}
+
+}  // namespace
+
+CodecResult parse_gomostr(std::string_view s, int &x, int &y)
+{
+    size_t i = 0;
+    while (i < s.size() && isBlank(s[i]))
+        i++;
+    if (!readInt(s, i, x))
+        return fail(CODEC_BAD_NUMBER, i);
+    if (i == s.size() || s[i] != ',')
+        return fail(i == s.size() ? CODEC_BAD_COUNT : CODEC_BAD_CHAR, i);
+    i++;
+    while (i < s.size() && isBlank(s[i]))
+        i++;
+    if (!readInt(s, i, y))
+        return fail(CODEC_BAD_NUMBER, i);
+    if (i != s.size())
+        return fail(s[i] == ',' ? CODEC_BAD_COUNT : CODEC_BAD_CHAR, i);
+    return {CODEC_OK, i};
+}
+
+CodecResult write_gomostr(char *buf, size_t size, int x, int y)
+{
+    size_t n = 0;
+    if (!writeInt(buf, size, n, x) || !writeChar(buf, size, n, ',')
+        || !writeInt(buf, size, n, y))
+        return fail(CODEC_NO_SPACE, n);
+    buf[n] = '\0';
+    return {CODEC_OK, n};
+}
+
+CodecResult
+write_opening_move(char *buf, size_t size, OpeningType type, int boardSize, Pos p)
+{
+    const int hboardSize = boardSize / 2;
+    size_t    n          = 0;
+    bool      ok;
+
+    switch (type) {
+    case OPENING_OFFSET:
+        ok = writeInt(buf, size, n, CoordX(p) - hboardSize) && writeChar(buf, size, n, ',')
+             && writeInt(buf, size, n, CoordY(p) - hboardSize);
+        break;
+    default:
+        ok = writeChar(buf, size, n, char(CoordX(p) + 'a'))
+             && writeInt(buf, size, n, CoordY(p) + 1);
+        break;
+    }
+
+    if (!ok)
+        return fail(CODEC_NO_SPACE, n);
+    buf[n] = '\0';
+    return {CODEC_OK, n};
+}
+
+CodecResult parse_opening(std::string_view s,
+                          OpeningType      type,
+                          int              boardSize,
+                          Pos             *moves,
+                          int              maxMoves,
+                          int             &count)
+{
+    const int hboardSize = boardSize / 2;
+    count                = 0;
+
+    size_t i = 0;
+    while (true) {
+        // skip separators, and stop at the end of the string
+        while (i < s.size() && (isBlank(s[i]) || (type == OPENING_OFFSET && s[i] == ',')))
+            i++;
+        if (i == s.size())
+            break;
+
+        const size_t start = i;
+        int          x, y;
+        if (type == OPENING_OFFSET) {
+            if (!isDigit(s[i]) && s[i] != '-')
+                return fail(CODEC_BAD_CHAR, i);
+            if (!readInt(s, i, x))
+                return fail(CODEC_BAD_NUMBER, i);
+            while (i < s.size() && (isBlank(s[i]) || s[i] == ','))
+                i++;
+            if (i == s.size())
+                return fail(CODEC_BAD_COUNT, start);
+            if (!isDigit(s[i]) && s[i] != '-')
+                return fail(CODEC_BAD_CHAR, i);
+            if (!readInt(s, i, y))
+                return fail(CODEC_BAD_NUMBER, i);
+            x += hboardSize;
+            y += hboardSize;
+        }
+        else {
+            if (s[i] < 'a' || s[i] > 'z')
+                return fail(isDigit(s[i]) ? CODEC_BAD_COUNT : CODEC_BAD_CHAR, i);
+            x = s[i++] - 'a';
+            if (i == s.size() || !isDigit(s[i]))
+                return fail(i == s.size() ? CODEC_BAD_COUNT : CODEC_BAD_CHAR, i);
+            if (!readInt(s, i, y))
+                return fail(CODEC_BAD_NUMBER, i);
+            y -= 1;
+        }
+
+        if (x < 0 || x >= boardSize || y < 0 || y >= boardSize)
+            return fail(CODEC_OUT_OF_BOARD, start);
+        if (count == maxMoves)
+            return fail(CODEC_BAD_COUNT, start);
+        moves[count++] = POS(x, y);
+    }
+
+    return {CODEC_OK, i};
+}
+
+const char *codec_status_str(CodecStatus status)
+{
+    switch (status) {
+    case CODEC_OK: return "ok";
+    case CODEC_BAD_CHAR: return "unexpected character";
+    case CODEC_BAD_NUMBER: return "bad number";
+    case CODEC_BAD_COUNT: return "wrong number of coordinates";
+    case CODEC_OUT_OF_BOARD: return "coordinates out of the board";
+    default: return "buffer too small";
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "position.h"
+
+#include <cstddef>
+#include <string_view>
+
+// Text codec for moves and openings. Nothing here allocates: parsers write into
+// caller arrays, writers into caller buffers (always NUL terminated on success).
+
+enum CodecStatus {
+    CODEC_OK,
+    CODEC_BAD_CHAR,      // a character that has no place in the format
+    CODEC_BAD_NUMBER,    // missing or malformed number
+    CODEC_BAD_COUNT,     // wrong number of coordinates (or too many moves)
+    CODEC_OUT_OF_BOARD,  // coordinates outside of the board
+    CODEC_NO_SPACE       // output buffer too small
+};
+
+struct CodecResult
+{
+    CodecStatus status;
+    size_t      pos;  // characters read or written, or offset of the error
+
+    explicit operator bool() const { return status == CODEC_OK; }
+};
+
+// "x,y" as exchanged with Gomocup engines. Blanks are allowed before each number.
+CodecResult parse_gomostr(std::string_view s, int &x, int &y);
+CodecResult write_gomostr(char *buf, size_t size, int x, int y);
+
+// One move of an opening: "x,y" offset from the centre (OPENING_OFFSET), or "h8"
+// (OPENING_POS, column letter and 1-based row)
+CodecResult
+write_opening_move(char *buf, size_t size, OpeningType type, int boardSize, Pos p);
+
+// Whole opening: "x,y, x,y, ..." (OPENING_OFFSET, comma or blank separated) or
+// "h8i9..." (OPENING_POS). Fills at most maxMoves cells, checked against the board.
+CodecResult parse_opening(std::string_view s,
+                          OpeningType      type,
+                          int              boardSize,
+                          Pos             *moves,
+                          int              maxMoves,
+                          int             &count);
+
+// Text for error messages
+const char *codec_status_str(CodecStatus status);
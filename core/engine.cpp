@@ -21,21 +21,28 @@
 #elif defined(__linux__)
     #define _GNU_SOURCE
     #include <fcntl.h>
+    #include <poll.h>
     #include <sys/prctl.h>
     #include <sys/wait.h>
     #include <unistd.h>
 #else
+    #include <fcntl.h>
+    #include <poll.h>
     #include <sys/wait.h>
     #include <unistd.h>
 #endif
 
 #include "engine.h"
+#include "aboutcache.h"
 #include "position.h"
+#include "reactor.h"
 #include "util.h"
 #include "workers.h"
 
 #include <cassert>
+#include <cerrno>
 #include <climits>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -43,6 +50,7 @@
 #include <mutex>
 #include <signal.h>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #ifdef __MINGW32__
@@ -89,25 +97,79 @@ static std::string argvQuote(std::string_view arg)
 }
 #endif
 
+#ifdef __linux__
+// PR_SET_PDEATHSIG fires when the thread that spawned the engine exits, not the process.
+// Pooled engines outlive the worker thread that started them, so all engines are
+// spawned by one thread, which lives as long as the process.
+static thread_local bool onSpawnThread = false;
+
+static void run_on_spawn_thread(const std::function<void()> &task)
+{
+    struct State
+    {
+        std::mutex                   callMtx;  // one task at a time
+        std::mutex                   mtx;
+        std::condition_variable      cv;
+        const std::function<void()> *task = nullptr;
+    };
+
+    // Never destroyed: the thread is still waiting on it at exit
+    static State *const s = [] {
+        State *state = new State;
+        std::thread([state] {
+            onSpawnThread = true;
+            std::unique_lock lock(state->mtx);
+            for (;;) {
+                state->cv.wait(lock, [state] { return state->task != nullptr; });
+                (*state->task)();
+                state->task = nullptr;
+                state->cv.notify_all();
+            }
+        }).detach();
+        return state;
+    }();
+
+    std::lock_guard  call(s->callMtx);
+    std::unique_lock lock(s->mtx);
+    s->task = &task;
+    s->cv.notify_all();
+    s->cv.wait(lock, [] { return s->task == nullptr; });
+}
+#endif
+
 Engine::Engine(Worker *worker, bool debug, std::string *outmsg)
     : w(worker)
     , isDebug(debug)
-    , in(nullptr)
-    , out(nullptr)
+    , inFd(-1)
+    , outFd(-1)
+    , readBegin(0)
+    , readEnd(0)
     , messages(outmsg)
     , tolerance(0)
+    , budgetSecond(0)
+    , budgetLines(0)
+    , gameMessageBytes(0)
+    , messagesCut(false)
     , pid(0)
 {}
 
 Engine::~Engine()
 {
     terminate();
+    close_pipes();
 }
 
 void Engine::spawn(const char *cwd, const char *run, char **argv, bool readStdErr)
 {
     assert(argv[0]);
 
+#ifdef __linux__
+    if (!onSpawnThread) {
+        run_on_spawn_thread([&] { spawn(cwd, run, argv, readStdErr); });
+        return;
+    }
+#endif
+
 #ifdef __MINGW32__
     // Setup the global job handle and job info, then bind parent process to it.
     // (This will only be called once)
@@ -223,8 +285,8 @@ void Engine::spawn(const char *cwd, const char *run, char **argv, bool readStdEr
     int stdout_fd = _open_osfhandle((intptr_t)p_stdout[0], _O_TEXT);
     DIE_IF(w->id, stdin_fd == -1);
     DIE_IF(w->id, stdout_fd == -1);
-    DIE_IF(w->id, !(this->in = _fdopen(stdout_fd, "r")));
-    DIE_IF(w->id, !(this->out = _fdopen(stdin_fd, "w")));
+    this->inFd  = stdout_fd;
+    this->outFd = stdin_fd;
 
     // Bind child process to the global job, so child process is killed when
     // parent process exits. (This is not needed actually, when parent process
@@ -244,15 +306,41 @@ void Engine::spawn(const char *cwd, const char *run, char **argv, bool readStdEr
     DIE_IF(w->id, pipe(into) < 0);
     #endif
 
-    DIE_IF(w->id, (this->pid = fork()) < 0);
+    // vfork(): the child borrows our address space until execvp(), instead of copying
+    // the page tables of a large multi-threaded process on every engine (re)start. It
+    // may only make system calls then, and passes any error back in childErrno.
+    volatile int childErrno = 0;
+    sigset_t     allSignals, oldMask;
+    sigfillset(&allSignals);
+    // no signal handler of ours may run in the child, on our stack
+    DIE_IF(w->id, pthread_sigmask(SIG_SETMASK, &allSignals, &oldMask) != 0);
+    #ifdef __linux__
+    const pid_t parent = getpid();
+    #endif
+
+    DIE_IF(w->id, (this->pid = vfork()) < 0);
 
     if (this->pid == 0) {
     #ifdef __linux__
-        prctl(PR_SET_PDEATHSIG, SIGHUP);  // delegate zombie purge to the kernel
+        prctl(PR_SET_PDEATHSIG, SIGHUP);  // dies with the cli (the spawn thread never exits)
+        if (getppid() != parent)          // too late: the parent died already
+            _exit(EXIT_FAILURE);
     #endif
+        // Default handlers, except for the signals ignored by whoever started us. SIGPIPE
+        // is ignored by the cli itself (see below), not by the engine.
+        for (int sig = 1; sig < NSIG; sig++) {
+            struct sigaction sa;
+            if (sigaction(sig, nullptr, &sa) == 0
+                && (sa.sa_handler != SIG_IGN || sig == SIGPIPE)) {
+                sa.sa_handler = SIG_DFL;
+                sa.sa_flags   = 0;
+                sigaction(sig, &sa, nullptr);
+            }
+        }
+        sigprocmask(SIG_SETMASK, &oldMask, nullptr);
+
         // Plug stdin and stdout
-        DIE_IF(w->id, dup2(into[0], STDIN_FILENO) < 0);
-        DIE_IF(w->id, dup2(outof[1], STDOUT_FILENO) < 0);
+        bool ok = dup2(into[0], STDIN_FILENO) >= 0 && dup2(outof[1], STDOUT_FILENO) >= 0;
 
         // For stderr we have 2 choices:
         // - readStdErr=true: dump it into stdout, like doing '2>&1' in bash. This is
@@ -262,8 +350,8 @@ void Engine::spawn(const char *cwd, const char *run, char **argv, bool readStdEr
         // - readStdErr=false: do nothing, which means stderr is inherited from the parent
         // process. Typcically, this means all engines write their error messages to the
         // terminal (unless redirected otherwise).
-        if (readStdErr)
-            DIE_IF(w->id, dup2(outof[1], STDERR_FILENO) < 0);
+        if (ok && readStdErr)
+            ok = dup2(outof[1], STDERR_FILENO) >= 0;
 
     #ifndef __linux__
         // Ugly (and slow) workaround for non-Linux POSIX systems that lack the ability to
@@ -273,19 +361,37 @@ void Engine::spawn(const char *cwd, const char *run, char **argv, bool readStdEr
     #endif
 
         // Set cwd as current directory, and execute run with argv[]
-        DIE_IF(w->id, chdir(cwd) < 0);
-        DIE_IF(w->id, execvp(run, argv) < 0);
+        if (ok && chdir(cwd) == 0)
+            execvp(run, argv);
+
+        childErrno = errno;
+        _exit(EXIT_FAILURE);
     }
-    else {
-        assert(this->pid > 0);
 
-        // in the parent process
-        DIE_IF(w->id, close(into[0]) < 0);
-        DIE_IF(w->id, close(outof[1]) < 0);
+    DIE_IF(w->id, pthread_sigmask(SIG_SETMASK, &oldMask, nullptr) != 0);
 
-        DIE_IF(w->id, !(this->in = fdopen(outof[0], "r")));
-        DIE_IF(w->id, !(this->out = fdopen(into[1], "w")));
+    if (childErrno) {
+        waitpid(this->pid, nullptr, 0);
+        DIE("[%d] failed to load engine \"%s\" from \"%s\": %s\n",
+            w->id,
+            run,
+            cwd,
+            strerror(childErrno));
     }
+
+    // in the parent process
+    DIE_IF(w->id, close(into[0]) < 0);
+    DIE_IF(w->id, close(outof[1]) < 0);
+
+    // Reads never block: readln() waits in poll(), with the deadline as timeout
+    this->inFd  = outof[0];
+    this->outFd = into[1];
+    DIE_IF(w->id, fcntl(inFd, F_SETFL, fcntl(inFd, F_GETFL) | O_NONBLOCK) < 0);
+
+    // A write to an engine that died must fail with EPIPE (and flag the engine as
+    // crashed), instead of killing the cli with SIGPIPE
+    static const bool ignoreSigpipe = signal(SIGPIPE, SIG_IGN) != SIG_ERR;
+    (void)ignoreSigpipe;
 #endif
 }
 
@@ -335,6 +441,21 @@ static void engine_parse_cmd(const char               *cmd,
         args.push_back(token);
 }
 
+// Path of the binary executed for (cwd, run), or just run when execvp() searches PATH
+static std::string engine_binary(const std::string &cwd, const std::string &run)
+{
+    const char *tail = string_prefix(run.c_str(), "./");
+    return tail ? format("%s/%s", cwd, tail) : run;
+}
+
+std::string Engine::binary_path(const char *cmd)
+{
+    std::string              cwd, run;
+    std::vector<std::string> args;
+    engine_parse_cmd(cmd, cwd, run, args);
+    return engine_binary(cwd, run);
+}
+
 void Engine::start(const char *cmd, const char *engine_name, int64_t engine_tolerance)
 {
     if (!*cmd)
@@ -357,13 +478,19 @@ void Engine::start(const char *cmd, const char *engine_name, int64_t engine_tole
         argv[i] = args[i].data();
     }
 
-    // Spawn child process and plug pipes
+    // Spawn child process and plug pipes (the ones of a timed out process are still open)
+    close_pipes();
     spawn(cwd.c_str(), run.c_str(), argv, w->log != NULL);
 
     delete[] argv;
 
+    // Hashing the binary (once per build of it) overlaps with the engine starting up
+    uint64_t aboutKey = 0;
+    if (aboutCache)
+        aboutKey = aboutCache->key(engine_binary(cwd, run), cmd);
+
     // parse engine ABOUT infomation
-    parse_about(cmd);
+    parse_about(cmd, aboutKey);
 }
 
 void Engine::terminate(bool force)
@@ -376,6 +503,7 @@ void Engine::terminate(bool force)
         // Order the engine to quit, and grant (tolerance) deadline for obeying
         w->deadline_set(name.c_str(), system_msec() + tolerance, "exit");
         writeln("END");
+        flush();
     }
 
 #ifdef __MINGW32__
@@ -389,50 +517,191 @@ void Engine::terminate(bool force)
     DIE_IF(w->id, !CloseHandle(hProcess));
 #else
     if (force) {
+        // The pipes are left open: this can run in the main thread (deadline callback)
+        // while the worker thread reads them. The worker sees EOF and closes them.
         if (waitpid(pid, NULL, WNOHANG) == 0)
             DIE_IF(w->id, kill(pid, SIGTERM) < 0);
     }
     else {
-        // On unix/linux, wait until deadline
-        waitpid(pid, NULL, 0);
+        // On unix/linux, wait for the engine to close its output until the deadline,
+        // then kill it if it is still running
+        const int64_t timeLimit = system_msec() + tolerance;
+        std::string   line;
+        while (readln(line, timeLimit))
+            ;
+        if (waitpid(pid, NULL, WNOHANG) == 0) {
+            DIE_IF(w->id, kill(pid, SIGKILL) < 0);
+            waitpid(pid, NULL, 0);
+        }
     }
 #endif
 
-    if (!force)
+    if (!force) {
         w->deadline_clear();
+        close_pipes();
+    }
 
-    if (in)
-        DIE_IF(w->id, fclose(in) < 0);
-    if (out)
-        DIE_IF(w->id, fclose(out) < 0);
-
-    // Reset pid, in, out
     pid = 0;
-    in = out = nullptr;
+}
+
+void Engine::attach(Worker *worker, std::string *outmsg)
+{
+    w        = worker;
+    messages = outmsg;
+}
+
+bool Engine::is_running() const
+{
+    if (!pid || is_crashed())
+        return false;
+
+#ifdef __MINGW32__
+    return WaitForSingleObject(hProcess, 0) == WAIT_TIMEOUT;
+#else
+    siginfo_t info = {};
+    return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && !info.si_pid;
+#endif
+}
+
+int64_t Engine::memory_usage() const
+{
+#ifdef __linux__
+    FILE *statm = fopen(format("/proc/%d/statm", (int)pid).c_str(), "r" FOPEN_TEXT);
+    if (!statm)
+        return -1;
+
+    long size, resident;
+    const bool ok = fscanf(statm, "%ld %ld", &size, &resident) == 2;
+    fclose(statm);
+    return ok ? (int64_t)resident * sysconf(_SC_PAGESIZE) : -1;
+#else
+    return -1;
+#endif
+}
+
+void Engine::close_pipes()
+{
+    if (inFd >= 0)
+        DIE_IF(w->id, close(inFd) < 0);
+    if (outFd >= 0)
+        DIE_IF(w->id, close(outFd) < 0);
+    inFd = outFd = -1;
+    readBegin = readEnd = 0;
+    writeBuf.clear();
+}
+
+// Makes room after readEnd: moves the unread output to the front of readBuf, or grows it
+// when it is full of unread output (only then is memory allocated, and zeroed)
+void Engine::make_read_room()
+{
+    if (readEnd < readBuf.size())
+        return;
+
+    if (readBegin) {
+        memmove(readBuf.data(), readBuf.data() + readBegin, readEnd - readBegin);
+        readEnd -= readBegin;
+        readBegin = 0;
+    }
+    else
+        readBuf.resize(std::max<size_t>(64 * 1024, 2 * readBuf.size()));
+}
+
+// Appends a chunk of engine output to readBuf. Returns 1, or 0 on EOF, or -1 when
+// timeLimit passes first (after firing the deadline callback from this thread).
+int Engine::read_chunk(int64_t timeLimit)
+{
+    make_read_room();
+
+    while (true) {
+        char        *buf  = readBuf.data() + readEnd;
+        const size_t room = readBuf.size() - readEnd;
+#ifdef __MINGW32__
+        // Windows pipes can not be polled: this blocks until the deadline callback
+        // kills the engine
+        const int n = _read(inFd, buf, (unsigned)room);
+#else
+        const ssize_t n = read(inFd, buf, room);
+
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            int ready;
+    #ifdef __linux__
+            // Run by a reactor task: let the other games of this thread go on meanwhile
+            if (Reactor *reactor = Reactor::current())
+                ready = reactor->wait_readable(inFd, timeLimit);
+            else
+    #endif
+            {
+                int64_t left = -1;  // no time limit
+                if (timeLimit)
+                    left = std::min<int64_t>(
+                        std::max<int64_t>(timeLimit - system_msec(), 0),
+                        INT_MAX);
+                pollfd pfd = {inFd, POLLIN, 0};
+                ready      = poll(&pfd, 1, (int)left);
+                DIE_IF(w->id, ready < 0 && errno != EINTR);
+            }
+
+            if (ready == 0) {
+                w->deadline_callback_once();
+                return -1;
+            }
+            continue;
+        }
+#endif
+        if (n < 0 && errno == EINTR)
+            continue;
+        DIE_IF(w->id, n < 0);
+
+        readEnd += n;
+        return n > 0;
+    }
 }
 
 // returns false when engine timeout or crash, and after that
 // is_crashed() can be used to check if the engine has crashed
-bool Engine::readln(std::string &line)
+bool Engine::readln(std::string &line, int64_t timeLimit)
 {
-    if (!in)  // Check if engine has crashed
+    if (!writeBuf.empty())  // the engine can only answer what it has received
+        flush();
+
+    if (inFd < 0)  // Check if engine has crashed
         return false;
 
-    if (!string_getline(line, in)) {
-        // When timeout, main thread will terminate the engine subprocess by force
-        // We wait for main thread to complete the termination callback
-        w->wait_callback_done();
-
-        // Pipe returning EOF means engine crashed
-        // Instead of dying instantly, close pipe to flag engine died and return false
-        if (pid) {  // If it is terminated by timeout, process is already closed
-            DIE_IF(w->id, fclose(in) < 0);
-            DIE_IF(w->id, fclose(out) < 0);
-            in = out = nullptr;
+    const char *newline = nullptr;
+    while (readBegin == readEnd
+           || !(newline = (const char *)memchr(readBuf.data() + readBegin,
+                                               '\n',
+                                               readEnd - readBegin))) {
+        if (readBegin == readEnd)  // all read: start again from the front
+            readBegin = readEnd = 0;
+
+        const int r = read_chunk(timeLimit);
+        if (r < 0)  // timeout: the deadline callback took care of the engine
+            return false;
+        if (r == 0) {
+            if (readBegin < readEnd) {  // a last line without newline
+                make_read_room();
+                readBuf[readEnd++] = '\n';
+                continue;
+            }
+
+            // When timeout, main thread will terminate the engine subprocess by force
+            // We wait for main thread to complete the termination callback
+            w->wait_callback_done();
+
+            // Pipe returning EOF means engine crashed
+            // Instead of dying instantly, close pipe to flag engine died and return false
+            close_pipes();
+            return false;
         }
-        return false;
     }
 
+    size_t end = newline - readBuf.data(), len = end - readBegin;
+    if (len && readBuf[end - 1] == '\r')  // CR+LF line endings
+        len--;
+    line.assign(readBuf.data() + readBegin, len);
+    readBegin = end + 1;
+
     if (w->log) {
         int64_t t = system_msec();
         DIE_IF(w->id,
@@ -445,38 +714,66 @@ bool Engine::readln(std::string &line)
 
 void Engine::writeln(const char *buf)
 {
-    if (!out)  // Check if engine has crashed
+    if (outFd < 0)  // Check if engine has crashed
         return;
 
-    DIE_IF(w->id, fputs(buf, out) < 0);
-    DIE_IF(w->id, fputc('\n', out) < 0);
+    writeBuf += buf;
+    writeBuf += '\n';
+}
 
-    // We take fflush error as engine crashed signal
-    if (fflush(out) < 0) {
-        // Instead of dying instantly, close pipe to flag engine died
-        DIE_IF(w->id, fclose(in) < 0);
-        DIE_IF(w->id, fclose(out) < 0);
-        in = out = nullptr;
+void Engine::flush()
+{
+    // logged when sent, with the time of the write
+    if (w->log && !writeBuf.empty()) {
+        const int64_t t = system_msec();
+        for (size_t begin = 0, end; begin < writeBuf.size(); begin = end + 1) {
+            end = writeBuf.find('\n', begin);
+            DIE_IF(w->id,
+                   fprintf(w->log,
+                           "%" PRId64 ": %s <- %.*s\n",
+                           t,
+                           name.c_str(),
+                           int(end - begin),
+                           writeBuf.data() + begin)
+                       < 0);
+        }
     }
 
-    if (w->log) {
-        int64_t t = system_msec();
-        DIE_IF(w->id,
-               fprintf(w->log, "%" PRId64 ": %s <- %s\n", t, name.c_str(), buf) < 0);
-        DIE_IF(w->id, fflush(w->log) < 0);
+    for (size_t done = 0; done < writeBuf.size() && outFd >= 0;) {
+#ifdef __MINGW32__
+        const int n = _write(outFd, writeBuf.data() + done, writeBuf.size() - done);
+#else
+        const ssize_t n = write(outFd, writeBuf.data() + done, writeBuf.size() - done);
+#endif
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        // We take a write error as engine crashed signal
+        if (n < 0) {
+            DIE_IF(w->id, errno != EPIPE);
+            // Instead of dying instantly, close pipe to flag engine died
+            close_pipes();
+            break;
+        }
+        done += n;
     }
+    writeBuf.clear();
+
+    if (w->log)
+        DIE_IF(w->id, fflush(w->log) < 0);
 }
 
 bool Engine::wait_for_ok(bool fatalError)
 {
-    std::string line;
-    w->deadline_set(name.c_str(), system_msec() + tolerance, "start", [=] {
+    std::string   line;
+    const int64_t timeLimit = system_msec() + tolerance;
+    w->deadline_set(name.c_str(), timeLimit, "start", [=] {
         if (!fatalError)
             terminate(true);
     });
 
     do {
-        if (!readln(line)) {
+        if (!readln(line, timeLimit)) {
             DIE_OR_ERR(fatalError,
                        "[%d] engine %s %s before answering START\n",
                        w->id,
@@ -518,13 +815,14 @@ bool Engine::bestmove(int64_t     &timeLeft,
     w->deadline_set(name.c_str(), turnTimeLimit + tolerance, "move", [=] {
         terminate(true);
     });
+    const int64_t readTimeLimit = turnTimeLimit + tolerance;
     // the maximum move overhead allowed is half of the tolerance
     int64_t     moveOverhead = tolerance / 2;
     bool        result       = false;
     std::string line;
 
     while ((turnTimeLeft + moveOverhead) >= 0 && !result) {
-        if (!readln(line))
+        if (!readln(line, readTimeLimit))
             goto Exit;
 
         const int64_t now = system_msec();
@@ -532,31 +830,9 @@ bool Engine::bestmove(int64_t     &timeLeft,
         timeLeft          = std::max<int64_t>(matchTimeLimit - now, 0);
         turnTimeLeft      = turnTimeLimit - now;
 
-        const char *tail = nullptr;
-        OutputType type = process_common_output(line.c_str(), tail, moveply);
-        if (type == OT_MESSAGE) {
-            // record engine messages
-            if (messages)
-                *messages += format("%i) %s: %s\n", moveply, name, tail);
-
-            // parse and store thing information to info
-            parse_thinking_message(tail, info);
-            if (onInfo) onInfo(info, moveply);
-        }
-        else if (type == OT_DIRECT) {
-             // Check if it's an info line (e.g. "Eval 10", "Depth 10")
-             // Gomocup engines often output these without "MESSAGE" prefix
-             if (line.find("Eval") != std::string::npos || line.find("eval") != std::string::npos || 
-                 line.find("score") != std::string::npos || line.find("Depth") != std::string::npos ||
-                 line.find("depth") != std::string::npos) {
-                  parse_thinking_message(line.c_str(), info);
-                  if (onInfo) onInfo(info, moveply);
-             }
-             
-             if (Position::is_valid_move_gomostr(line)) {
-                best   = line;
-                result = true;
-             }
+        if (process_thinking_output(line, info, moveply, now)) {
+            best   = line;
+            result = true;
         }
     }
 
@@ -569,16 +845,9 @@ bool Engine::bestmove(int64_t     &timeLeft,
         timeLeft = INT64_MIN;
 
         do {
-            if (!readln(line))
+            if (!readln(line, readTimeLimit))
                 goto Exit;
-
-            if (const char *tail;
-                process_common_output(line.c_str(), tail, moveply) == OT_MESSAGE) {
-                // parse and store thinking information to info
-                parse_thinking_message(tail, info);
-                if (onInfo) onInfo(info, moveply);
-            }
-        } while (result = Position::is_valid_move_gomostr(line), !result);
+        } while (!(result = process_thinking_output(line, info, moveply, system_msec())));
     }
 
 Exit:
@@ -653,23 +922,30 @@ static void parse_and_display_engine_about(const Worker    *w,
                 country.c_str());
 }
 
-// process engine ABOUT command
-void Engine::parse_about(const char *fallbackName)
+// process engine ABOUT command, unless the answer is cached under aboutKey
+void Engine::parse_about(const char *fallbackName, uint64_t aboutKey)
 {
-    w->deadline_set(!name.empty() ? name.c_str() : fallbackName,
-                    system_msec() + tolerance,
-                    "about");
-    writeln("ABOUT");
-
-    // read about output (skip other outputs first)
     std::string line;
-    const char *tail;
-    do {
-        if (!readln(line))
-            DIE("[%d] engine %s exited before answering ABOUT\n", w->id, name.c_str());
-    } while (process_common_output(line.c_str(), tail) != OT_DIRECT);
 
-    w->deadline_clear();
+    if (!aboutKey || !aboutCache->lookup(aboutKey, line)) {
+        const int64_t timeLimit = system_msec() + tolerance;
+        w->deadline_set(!name.empty() ? name.c_str() : fallbackName, timeLimit, "about");
+        writeln("ABOUT");
+
+        // read about output (skip other outputs first)
+        std::string_view tail;
+        do {
+            if (!readln(line, timeLimit))
+                DIE("[%d] engine %s exited before answering ABOUT\n",
+                    w->id,
+                    name.c_str());
+        } while (process_common_output(line, tail) != OT_DIRECT);
+
+        w->deadline_clear();
+
+        if (aboutKey)
+            aboutCache->store(aboutKey, line);
+    }
 
     // parse about infos
     parse_and_display_engine_about(w, line, name);
@@ -680,85 +956,105 @@ void Engine::parse_about(const char *fallbackName)
 }
 
 // process MESSAGE, UNKNOWN, ERROR, DEBUG messages
-// @param tail_out Pointer to receive the start position of output without prefix.
-Engine::OutputType Engine::process_common_output(const char *line, const char *&tail, int ply)
+// @param tail Receives the output without its prefix.
+OutputType Engine::process_common_output(std::string_view line, std::string_view &tail)
 {
-    tail            = nullptr;
-    OutputType type = OT_DIRECT;
-
-    if ((tail = string_prefix(line, "MESSAGE")))
-        type = OT_MESSAGE;
-    else if ((tail = string_prefix(line, "DEBUG")))
-        type = OT_DEBUG;
-    else if ((tail = string_prefix(line, "UNKNOWN")))
-        type = OT_UNKNOWN;
-    else if ((tail = string_prefix(line, "ERROR")))
-        type = OT_ERROR;
-    else if ((tail = string_prefix(line, "SUGGEST")))
-        type = OT_SUGGEST;
-    else
-        tail = line;
-
-    if (type != OT_DIRECT && strlen(tail) > 0)
-        tail += 1;  // skip one space
+    const OutputType type = classify_output(line, tail);
 
     if (isDebug && type != OT_DIRECT) {
         const char *outputTypeStrings[] =
             {"", "unknown", "error", "message", "debug", "suggest"};
-        printf("Engine %s output %s: %s\n", name.c_str(), outputTypeStrings[type], tail);
+        printf("Engine %s output %s: %.*s\n",
+               name.c_str(),
+               outputTypeStrings[type],
+               (int)tail.size(),
+               tail.data());
     }
 
-    if (type == OT_MESSAGE && onMessage) {
+    if (type == OT_MESSAGE && onMessage && budget.message != OUTPUT_DROP) {
         onMessage(tail);
     }
 
     return type;
 }
 
-void Engine::parse_thinking_message([[maybe_unused]] const char *line, Info &info)
+// Handles a line read while thinking: returns true for a move, otherwise logs, records
+// and parses the line, as far as the output budget allows
+bool Engine::process_thinking_output(const std::string &line,
+                                     Info              &info,
+                                     int                ply,
+                                     int64_t            now)
 {
-    // Replace '=' with space to handle "depth=10" and "depth 10" uniformly
-    std::string temp = line;
-    for (char &c : temp) {
-        if (c == '=') c = ' ';
-    }
-
-    std::stringstream ss(temp);
-    std::string token;
-    
-    while (ss >> token) {
-        if (token == "depth" || token == "Depth") {
-            if (ss >> token) info.depth = std::atoi(token.c_str());
+    if (Position::is_valid_move_gomostr(line))
+        return true;
+
+    outputStats.lines++;
+    if (budget.lines) {
+        if (now - budgetSecond >= 1000) {
+            budgetSecond = now;
+            budgetLines  = 0;
         }
-        else if (token == "time" || token == "Time") {
-            if (ss >> token) info.time = std::atoll(token.c_str());
+        if (budgetLines >= budget.lines) {
+            outputStats.dropped++;
+            return false;
         }
-        else if (token == "score" || token == "eval" || token == "Eval") {
-            std::string val;
-            if (ss >> val) {
-                if (val == "cp") {
-                    if (ss >> val) info.score = std::atoi(val.c_str());
-                }
-                else if (val == "mate") {
-                    if (ss >> val) {
-                        int m = std::atoi(val.c_str());
-                        // Encode mate score: >0 for win, <0 for loss
-                        // We use a large number outside normal cp range (e.g. +/- 30000)
-                        if (m > 0) info.score = 30000 - m;
-                        else info.score = -30000 - m;
-                    }
-                }
-                else {
-                    // direct score or "mate" was implicit? 
-                    // Assume direct cp score if it's a number
-                    try {
-                        size_t idx;
-                        int s = std::stoi(val, &idx);
-                        if (idx == val.size()) info.score = s;
-                    } catch(...) {}
-                }
-            }
+        budgetLines++;
+    }
+
+    std::string_view tail;
+    const OutputType type = process_common_output(line, tail);
+
+    if (type == OT_MESSAGE && budget.message != OUTPUT_DROP) {
+        record_message(tail, ply);
+
+        if (budget.message == OUTPUT_PARSE) {
+            parse_info(tail, info);
+            if (onInfo) onInfo(info, ply);
         }
     }
+    // Gomocup engines often output info lines (e.g. "depth 10 eval 10") without the
+    // MESSAGE prefix
+    else if (type == OT_DIRECT && budget.plain == OUTPUT_PARSE && parse_info(tail, info)
+             && onInfo)
+        onInfo(info, ply);
+
+    return false;
+}
+
+// Records a message (with -msg), up to the bytes per game of the output budget. Once one
+// is dropped, the rest of the game's messages are too, so the record has no gaps.
+void Engine::record_message(std::string_view text, int ply)
+{
+    if (!messages)
+        return;
+
+    if (messagesCut
+        || (budget.bytes && gameMessageBytes + (int64_t)text.size() > budget.bytes)) {
+        if (!messagesCut)
+            *messages += format("%i) %s: (messages beyond %" PRId64 " bytes dropped)\n",
+                                ply,
+                                name,
+                                budget.bytes);
+        messagesCut = true;
+        outputStats.droppedBytes += text.size();
+        return;
+    }
+
+    gameMessageBytes += text.size();
+    *messages += format("%i) %s: ", ply, name);
+    messages->append(text).push_back('\n');
 }
 
+void Engine::reset_output_budget(const OutputBudget &outputBudget)
+{
+    budget           = outputBudget;
+    gameMessageBytes = 0;
+    messagesCut      = false;
+}
+
+OutputStats Engine::take_output_stats()
+{
+    const OutputStats stats = outputStats;
+    outputStats             = {};
+    return stats;
+}
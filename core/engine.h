@@ -19,32 +19,31 @@
     #include <sys/types.h>
 #endif
 
+#include "engineoutput.h"
+
 #include <functional>
 #include <cstdio>
 #include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
+class AboutCache;
 class Worker;
 
-// Elements remembered from parsing info lines (for writing PGN comments)
-struct Info
-{
-    int     score, depth;
-    int64_t time;
-};
-
 // Engine process
 class Engine
 {
 public:
     std::string name;
+    AboutCache *aboutCache = nullptr;  // ABOUT answers cached across runs (optional)
 
     Engine(Worker *worker, bool debug, std::string *outmsg);
     Engine(const Engine &) = delete;  // disable copy
     ~Engine();
 
     // Callback for engine messages (PV, depth, eval, etc.)
-    std::function<void(const std::string&)> onMessage = nullptr;
+    std::function<void(std::string_view)> onMessage = nullptr;
 
     // Callback for parsed info
     std::function<void(const Info&, int ply)> onInfo = nullptr;
@@ -52,8 +51,18 @@ public:
     void start(const char *cmd, const char *name, int64_t tolerance);
     void terminate(bool force = false);
 
-    bool readln(std::string &line);
+    // hands a running engine over to another worker (see EnginePool)
+    void attach(Worker *worker, std::string *outmsg);
+
+    // reads a line, waiting until timeLimit (system_msec() time, 0 for none): on timeout
+    // the worker deadline fires, on EOF the engine is flagged as crashed
+    bool readln(std::string &line, int64_t timeLimit = 0);
+
+    // queues a line: queued lines are sent together with a single write, by flush(),
+    // which readln() and terminate() call before waiting for the engine, and which is
+    // called at the end of each game (lines are logged when sent)
     void writeln(const char *buf);
+    void flush();
 
     bool wait_for_ok(bool fatalError);
     bool bestmove(int64_t     &timeLeft,
@@ -62,15 +71,33 @@ public:
                   Info        &info,
                   int          moveply);
 
+    // applies an output budget for a new game (and resets its count of message bytes)
+    void        reset_output_budget(const OutputBudget &budget);
+    OutputStats take_output_stats();  // since the last call
+
+    static std::string binary_path(const char *cmd);  // the binary that cmd executes
+
     bool is_ok() const { return pid != 0; }
-    bool is_crashed() const { return pid && (!in || !out); }
+    bool is_crashed() const { return pid && (inFd < 0 || outFd < 0); }
+    bool is_running() const;  // the process has not exited (without reaping it)
+
+    int64_t memory_usage() const;  // resident memory in bytes, -1 when unknown
 
 private:
-    Worker *const w;
-    const bool    isDebug;
-    FILE         *in, *out;
-    std::string  *messages;
-    int64_t       tolerance;
+    Worker           *w;
+    const bool        isDebug;
+    int               inFd, outFd;         // pipes from and to the engine
+    std::vector<char> readBuf;             // engine output read ahead
+    size_t            readBegin, readEnd;  // unread output in readBuf
+    std::string       writeBuf;            // lines queued by writeln(), not sent yet
+    std::string      *messages;
+    int64_t           tolerance;
+    OutputBudget      budget;
+    OutputStats       outputStats;
+    int64_t           budgetSecond;        // start of the second counted by budgetLines
+    int               budgetLines;         // lines handled in that second
+    int64_t           gameMessageBytes;    // message bytes recorded in the current game
+    bool              messagesCut;         // some were dropped in the current game
 
 #ifdef __MINGW32__
     long  pid;
@@ -79,17 +106,15 @@ private:
     pid_t pid;
 #endif
 
-    enum OutputType {
-        OT_DIRECT,   // No prefix
-        OT_UNKNOWN,  // Output with prefix "UNKNOWN"
-        OT_ERROR,    // Output with prefix "ERROR"
-        OT_MESSAGE,  // Output with prefix "MESSAGE"
-        OT_DEBUG,    // Output with prefix "DEBUG"
-        OT_SUGGEST,  // Output with prefix "SUGGEST"
-    };
-
     void       spawn(const char *cwd, const char *run, char **argv, bool readStdErr);
-    void       parse_about(const char *fallbackName);
-    OutputType process_common_output(const char *line, const char *&tail_out, int ply = -1);
-    void       parse_thinking_message(const char *line, Info &info);
+    void       make_read_room();
+    int        read_chunk(int64_t timeLimit);
+    void       close_pipes();
+    void       parse_about(const char *fallbackName, uint64_t aboutKey);
+    OutputType process_common_output(std::string_view line, std::string_view &tail);
+    bool       process_thinking_output(const std::string &line,
+                                       Info              &info,
+                                       int                ply,
+                                       int64_t            now);
+    void       record_message(std::string_view text, int ply);
 };
@@ -0,0 +1,135 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "engineoutput.h"
+
+#include <charconv>
+#include <climits>
+
+namespace {
+
+bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f'
+           || c == '=';  // "depth=10" reads as "depth 10"
+}
+
+// Token of s starting at or after s[i] (empty when there is none), and moves i past it
+std::string_view nextToken(std::string_view s, size_t &i)
+{
+    while (i < s.size() && isSeparator(s[i]))
+        i++;
+    const size_t first = i;
+    while (i < s.size() && !isSeparator(s[i]))
+        i++;
+    return s.substr(first, i - first);
+}
+
+// Leading number of a token, 0 if there is none (as atoi() reads it)
+template <typename T> T leadingInt(std::string_view t)
+{
+    if (t.size() > 1 && t[0] == '+' && t[1] >= '0' && t[1] <= '9')
+        t.remove_prefix(1);
+    T value = 0;
+    std::from_chars(t.data(), t.data() + t.size(), value);  // unchanged on failure
+    return value;
+}
+
+// Whole token as a number
+bool wholeInt(std::string_view t, int &value)
+{
+    if (t.size() > 1 && t[0] == '+' && t[1] >= '0' && t[1] <= '9')
+        t.remove_prefix(1);
+    auto [ptr, ec] = std::from_chars(t.data(), t.data() + t.size(), value);
+    return ec == std::errc() && ptr == t.data() + t.size();
+}
+
+}  // namespace
+
+OutputType classify_output(std::string_view line, std::string_view &tail)
+{
+    static const std::string_view Prefixes[] =
+        {"", "UNKNOWN", "ERROR", "MESSAGE", "DEBUG", "SUGGEST"};
+
+    // The first letter tells which prefix the line can have, if any
+    OutputType type = OT_DIRECT;
+    switch (line.empty() ? '\0' : line[0]) {
+    case 'U': type = OT_UNKNOWN; break;
+    case 'E': type = OT_ERROR; break;
+    case 'M': type = OT_MESSAGE; break;
+    case 'D': type = OT_DEBUG; break;
+    case 'S': type = OT_SUGGEST; break;
+    }
+
+    const std::string_view prefix = Prefixes[type];
+    if (type == OT_DIRECT || line.compare(0, prefix.size(), prefix) != 0) {
+        tail = line;
+        return OT_DIRECT;
+    }
+
+    tail = line.substr(prefix.size());
+    if (!tail.empty())
+        tail.remove_prefix(1);  // skip one space
+    return type;
+}
+
+bool parse_info(std::string_view s, Info &info)
+{
+    bool             found = false;
+    size_t           i     = 0;
+    std::string_view key, value;
+
+    while (!(key = nextToken(s, i)).empty()) {
+        if (key == "depth" || key == "Depth") {
+            if (!(value = nextToken(s, i)).empty())
+                info.depth = leadingInt<int>(value);
+        }
+        else if (key == "time" || key == "Time") {
+            if (!(value = nextToken(s, i)).empty())
+                info.time = leadingInt<int64_t>(value);
+        }
+        else if (key == "nodes" || key == "Nodes") {
+            if (!(value = nextToken(s, i)).empty())
+                info.nodes = leadingInt<int64_t>(value);
+        }
+        else if (key == "nps" || key == "Nps" || key == "NPS") {
+            if (!(value = nextToken(s, i)).empty())
+                info.nps = leadingInt<int64_t>(value);
+        }
+        else if (key == "score" || key == "eval" || key == "Eval") {
+            value = nextToken(s, i);
+            if (value == "cp") {
+                if (!(value = nextToken(s, i)).empty())
+                    info.score = leadingInt<int>(value);
+            }
+            else if (value == "mate") {
+                if (!(value = nextToken(s, i)).empty()) {
+                    // Mate in m (m > 0) or mated in -m
+                    const int m = leadingInt<int>(value);
+                    info.score  = m > 0 ? SCORE_MATE - m : -SCORE_MATE - m;
+                }
+            }
+            else if (int score; wholeInt(value, score))
+                info.score = score;
+        }
+        else
+            continue;
+
+        found = true;
+    }
+
+    return found;
+}
@@ -0,0 +1,74 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Engine output lines: their type, and the thinking information they carry. Nothing here
+// allocates: lines are read through views, numbers straight into Info.
+
+// "mate <n>" scores are encoded as SCORE_MATE - n for a win, -SCORE_MATE + n for a loss
+const int SCORE_MATE        = 30000;
+const int SCORE_MATE_IN_MAX = SCORE_MATE - 1000;  // smallest mate score
+
+// Elements remembered from parsing info lines (for writing PGN comments)
+struct Info
+{
+    int     score, depth;
+    int64_t time;
+    int64_t nodes, nps;
+};
+
+enum OutputType {
+    OT_DIRECT,   // No prefix
+    OT_UNKNOWN,  // Output with prefix "UNKNOWN"
+    OT_ERROR,    // Output with prefix "ERROR"
+    OT_MESSAGE,  // Output with prefix "MESSAGE"
+    OT_DEBUG,    // Output with prefix "DEBUG"
+    OT_SUGGEST,  // Output with prefix "SUGGEST"
+};
+
+// What is done with a line of thinking output: parse it (for the PGN comments, the GUI
+// and the adjudications, which need scores) and log it, log it only, or drop it
+enum OutputMode { OUTPUT_PARSE, OUTPUT_LOG, OUTPUT_DROP };
+
+// Output budget of an engine, so that a chatty one can not slow the tournament host.
+// Lines beyond it are still read (a move is never dropped), but not logged nor parsed.
+struct OutputBudget
+{
+    int        lines   = 0;             // lines handled per second (0 for none)
+    int64_t    bytes   = 0;             // message bytes recorded per game (0 for none)
+    OutputMode message = OUTPUT_PARSE;  // MESSAGE lines
+    OutputMode plain   = OUTPUT_PARSE;  // lines without prefix (no OUTPUT_LOG)
+};
+
+// Output read from an engine, and what went beyond its budget
+struct OutputStats
+{
+    uint64_t lines        = 0;  // lines read while thinking, but the moves
+    uint64_t dropped      = 0;  // lines beyond the lines per second
+    uint64_t droppedBytes = 0;  // message bytes beyond the bytes per game
+};
+
+// Type of a line, and in tail the text after its prefix (and the space following it)
+OutputType classify_output(std::string_view line, std::string_view &tail);
+
+// Reads "key value" (or "key=value") pairs into info: depth, time, nodes, nps, and score
+// or eval, as "cp <n>", "mate <n>" or "<n>". Other words are skipped. Returns true if any
+// of these keys was found.
+bool parse_info(std::string_view s, Info &info);
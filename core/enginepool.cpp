@@ -0,0 +1,159 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "enginepool.h"
+
+#include "util.h"
+
+#include <cassert>
+
+EnginePool::EnginePool(const std::vector<EngineOptions> &engineOptions,
+                       const PoolParams                 &poolParams,
+                       AboutCache                       *cache,
+                       bool                              isDebug)
+    : eo(engineOptions)
+    , params(poolParams)
+    , aboutCache(cache)
+    , debug(isDebug)
+    , memory(0)
+    , started(0)
+    , reused(0)
+    , evicted(0)
+{}
+
+EnginePool::~EnginePool()
+{
+    assert(idle.empty());  // clear() terminates them
+}
+
+Engine *EnginePool::acquire(int ei, Worker *w, std::string *messages)
+{
+    Engine              *engine = nullptr;
+    std::vector<Engine *> exited;
+
+    {
+        std::lock_guard lock(mtx);
+
+        for (auto it = idle.begin(); it != idle.end() && !engine;) {
+            if (it->ei != ei) {
+                ++it;
+                continue;
+            }
+
+            if (it->engine->is_running())
+                engine = it->engine;
+            else
+                exited.push_back(it->engine);  // died while idle
+
+            memory -= it->memory;
+            it = idle.erase(it);
+        }
+
+        if (engine)
+            reused++;
+        else
+            started++;
+    }
+
+    for (Engine *e : exited) {
+        e->attach(w, nullptr);
+        delete e;  // reaps the process
+    }
+
+    if (engine)
+        engine->attach(w, messages);
+    else {
+        engine             = new Engine(w, debug, messages);
+        engine->aboutCache = aboutCache;
+        engine->start(eo[ei].cmd.c_str(), eo[ei].name.c_str(), eo[ei].tolerance);
+    }
+
+    return engine;
+}
+
+void EnginePool::release(int ei, Engine *engine, Worker *w)
+{
+    std::vector<Engine *> evict;
+
+    engine->flush();  // what the last game queued is not left for the next one
+
+    if (params.idle && engine->is_ok() && !engine->is_crashed()) {
+        int64_t engineMemory = engine->memory_usage();
+        if (engineMemory < 0)  // unknown: assume the engine uses all it was allowed to
+            engineMemory = eo[ei].maxMemory;
+
+        // The callbacks refer to the releasing worker's game, which is about to end
+        engine->onMessage = nullptr;
+        engine->onInfo    = nullptr;
+
+        std::lock_guard lock(mtx);
+
+        idle.push_front({ei, engine, engineMemory});
+        memory += engineMemory;
+        engine = nullptr;
+
+        // Bound per engine, then memory budget: the least recently used ones go first
+        int count = 0;
+        for (auto it = idle.begin(); it != idle.end();) {
+            if (it->ei == ei && ++count > params.idle) {
+                evict.push_back(it->engine);
+                memory -= it->memory;
+                it = idle.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        while (params.memoryMB && memory > int64_t(params.memoryMB << 20)) {
+            evict.push_back(idle.back().engine);
+            memory -= idle.back().memory;
+            idle.pop_back();
+        }
+
+        evicted += evict.size();
+    }
+
+    if (engine)  // crashed, timed out, or no pool
+        evict.push_back(engine);
+
+    for (Engine *e : evict) {
+        e->attach(w, nullptr);
+        delete e;  // terminates the engine
+    }
+}
+
+void EnginePool::clear(Worker *w)
+{
+    std::lock_guard lock(mtx);
+
+    for (Idle &i : idle) {
+        i.engine->attach(w, nullptr);
+        delete i.engine;
+    }
+
+    idle.clear();
+    memory = 0;
+}
+
+std::string EnginePool::stats() const
+{
+    std::lock_guard lock(mtx);
+    return format("Engine pool: %" PRIu64 " started, %" PRIu64 " reused, %" PRIu64
+                  " evicted\n",
+                  started,
+                  reused,
+                  evicted);
+}
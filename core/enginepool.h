@@ -0,0 +1,74 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "engine.h"
+#include "options.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class AboutCache;
+class Worker;
+
+// Tournament-wide pool of idle engine processes, already started (ABOUT answered,
+// weights loaded), so that a worker switching pairs borrows a running engine instead of
+// spawning a new one. Idle engines are kept per engine index, up to a bound, and the
+// least recently used ones are evicted when their memory exceeds the budget. With no
+// idle engines allowed, release() terminates, and acquire() always starts a new engine.
+class EnginePool
+{
+public:
+    EnginePool(const std::vector<EngineOptions> &eo,
+               const PoolParams                 &params,
+               AboutCache                       *aboutCache,
+               bool                              debug);
+    ~EnginePool();
+
+    // An engine running eo[ei] for worker w (reused or started by the calling thread)
+    Engine *acquire(int ei, Worker *w, std::string *messages);
+
+    // Gives back an engine acquired for eo[ei]: kept idle if it is healthy and there is
+    // room, terminated by the calling worker w otherwise
+    void release(int ei, Engine *engine, Worker *w);
+
+    // Terminates all idle engines, using worker w
+    void clear(Worker *w);
+
+    std::string stats() const;
+
+private:
+    struct Idle
+    {
+        int     ei;
+        Engine *engine;
+        int64_t memory;  // resident memory when released, in bytes
+    };
+
+    const std::vector<EngineOptions> &eo;
+    const PoolParams                  params;
+    AboutCache *const                 aboutCache;  // given to the engines started
+    const bool                        debug;
+
+    mutable std::mutex mtx;
+    std::list<Idle>    idle;  // most recently released first
+    int64_t            memory;
+    uint64_t           started, reused, evicted;
+};
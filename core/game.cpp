@@ -19,22 +19,27 @@
 #include "options.h"
 #include "position.h"
 #include "util.h"
+#include "vcf.h"
 #include "workers.h"
 
 #include <climits>
 #include <cstring>
 #include <ctime>
 #include <iostream>
+#include <memory>
 #include <string>
 
 Game::Game(int rd, int gm, Worker *worker)
     : game_rule()
+    , rules()
     , round(rd)
     , game(gm)
     , ply()
     , state()
     , board_size()
+    , openingPly()
     , w(worker)
+    , solvedCache()
 {}
 
 bool Game::load_opening(std::string_view opening_str,
@@ -42,10 +47,10 @@ bool Game::load_opening(std::string_view opening_str,
                         size_t           currentRound,
                         Color           &color)
 {
-    pos.emplace_back(o.boardSize);
+    pos = Position(o.boardSize);
 
-    if (pos[0].apply_opening(opening_str, o.openingType)) {
-        color = pos[0].get_turn();
+    if (pos.apply_opening(opening_str, o.openingType)) {
+        color = pos.get_turn();
     }
     else {
         return false;
@@ -53,30 +58,57 @@ bool Game::load_opening(std::string_view opening_str,
 
     if (o.transform) {
         TransformType transType = (TransformType)(currentRound % NB_TRANS);
-        pos[0].transform(transType);
+        pos.transform(transType);
     }
 
+    openingPly = pos.get_move_count();
     return true;
 }
 
 // Applies rules to generate legal moves, and determine the state of the game
-int Game::game_apply_rules(move_t lastmove)
+int Game::game_apply_rules(bool ruleCheck)
 {
-    bool allow_long_connection = true;
-    if (game_rule == GOMOKU_EXACT_FIVE) {
-        allow_long_connection = false;
-    }
-    else if (game_rule == RENJU) {
-        if (ColorFromMove(lastmove) == BLACK)
-            allow_long_connection = false;
+    const bool fiveConnect = rules->five_lastmove(pos);
+
+    // Regression mode: the last move check must agree with a full board scan, on the
+    // result and on the win connection
+    if (ruleCheck && pos.get_move_count() >= 5) {
+        Position   fullScan     = pos;
+        const bool fullScanFive = rules->five_full_scan(fullScan);
+
+        auto connection = [](const Position &p) {
+            std::string str;
+            for (int i = 0; i < p.get_win_connection_len(); i++)
+                str += (i ? "," : "") + p.move_to_gomostr(p.get_win_connection()[i]);
+            return str;
+        };
+
+        if (fullScanFive != fiveConnect
+            || (fiveConnect
+                && (fullScan.get_win_connection_len() != pos.get_win_connection_len()
+                    || memcmp(fullScan.get_win_connection(),
+                              pos.get_win_connection(),
+                              pos.get_win_connection_len() * sizeof(Pos))))) {
+            DIE("[%d] rule check failed: last move check (%d, connection %s) differs "
+                "from full scan (%d, connection %s) at '%s'\n",
+                w->id,
+                (int)fiveConnect,
+                connection(pos).c_str(),
+                (int)fullScanFive,
+                connection(fullScan).c_str(),
+                pos.to_opening_str(OPENING_POS).c_str());
+        }
     }
 
-    if (pos[ply].check_five_in_line_lastmove(allow_long_connection)) {
+    if (fiveConnect) {
         return STATE_FIVE_CONNECT;
     }
-    else if (pos[ply].get_moves_left() == 0) {
+    else if (pos.get_moves_left() == 0) {
         return STATE_DRAW_INSUFFICIENT_SPACE;
     }
+    else if (pos.is_dead()) {
+        return STATE_DRAW_DEAD_POSITION;
+    }
 
     // game does not end
     return STATE_NONE;
@@ -139,9 +171,14 @@ void Game::send_board_command(const Position &position, Engine &engine)
     for (int i = 0; i < moveCnt; i++) {
         Color color           = ColorFromMove(histMoves[i]);
         int   gomocupColorIdx = colorToGomocupStoneIdx(color);
-        Pos   p               = PosFromMove(histMoves[i]);
 
-        engine.writeln(format("%i,%i,%i", CoordX(p), CoordY(p), gomocupColorIdx).c_str());
+        // "x,y,c" written in place, without going through a formatted string
+        char   line[32];
+        size_t n  = position.move_to_gomostr(histMoves[i], line, sizeof(line) - 2);
+        line[n++] = ',';
+        line[n++] = char('0' + gomocupColorIdx);
+        line[n]   = '\0';
+        engine.writeln(line);
     }
 
     engine.writeln("DONE");
@@ -160,8 +197,19 @@ void Game::compute_time_left(const EngineOptions &eo, int64_t &timeLeft)
     }
 }
 
+// Two consecutive scores, from the pov of each side, agree on the winner: mate scores of
+// opposite sign and close distances, or plain scores beyond the threshold if one is set
+static bool scores_agree(int previous, int score, const ConsensusParams &c)
+{
+    if ((previous > 0) == (score > 0))
+        return false;
+    if (abs(previous) >= SCORE_MATE_IN_MAX && abs(score) >= SCORE_MATE_IN_MAX)
+        return abs(abs(previous) - abs(score)) <= c.mate;
+    return c.score && abs(previous) >= c.score && abs(score) >= c.score;
+}
+
 int Game::play(const Options       &o,
-               Engine               engines[2],
+               Engine              *engines[2],
                const EngineOptions *eo[2],
                bool                 reverse)
 // Play a game:
@@ -173,6 +221,7 @@ int Game::play(const Options       &o,
     move_t  played                = NONE_MOVE;
     int     drawPlyCount          = 0;
     int     resignCount[NB_COLOR] = {0, 0};
+    int     consensusPlies        = 0;           // plies of agreeing scores in a row
     int     ei                    = reverse;     // engines[ei] has the move
     int64_t timeLeft[2]           = {0LL, 0LL};  // {eo[0]->time, eo[1]->time};
     bool    canUseTurn[2]         = {false, false};
@@ -180,28 +229,37 @@ int Game::play(const Options       &o,
     // initialize game rule
     this->game_rule  = (GameRule)(o.gameRule);
     this->board_size = o.boardSize;
+    this->rules      = &RuleKernel::get(o.boardSize, game_rule);
+
+    // searched after each move when VCF adjudication is enabled (on the heap: its
+    // failure cache is too big for the stack of a game)
+    std::unique_ptr<VcfSolver> vcf;
+    if (o.vcf.nodes)
+        vcf.reset(new VcfSolver(game_rule, o.vcf.nodes, o.vcf.time, o.vcf.depth));
 
     for (int color = BLACK; color <= WHITE; color++) {
-        names[color] = engines[color ^ pos[0].get_turn() ^ reverse].name;
+        names[color] = engines[color ^ pos.get_turn() ^ reverse]->name;
     }
 
     for (int i = 0; i < 2; i++) {
+        engines[i]->reset_output_budget(eo[i]->output);
+
         // tell engine to start a new game
-        engines[i].writeln(format("START %i", o.boardSize).c_str());
+        engines[i]->writeln(format("START %i", o.boardSize).c_str());
 
         // wait for engine to answer OK
-        if (!engines[i].wait_for_ok(o.fatalError)) {
-            state = engines[i].is_crashed() ? STATE_CRASHED : STATE_TIME_LOSS;
+        if (!engines[i]->wait_for_ok(o.fatalError)) {
+            state = engines[i]->is_crashed() ? STATE_CRASHED : STATE_TIME_LOSS;
             DIE_OR_ERR(o.fatalError,
                        "[%d] engine %s %s at start\n",
                        w->id,
-                       engines[i].name.c_str(),
-                       engines[i].is_crashed() ? "crashed" : "timeout");
+                       engines[i]->name.c_str(),
+                       engines[i]->is_crashed() ? "crashed" : "timeout");
             return i == 0 ? RESULT_LOSS : RESULT_WIN;
         }
 
         // send game info
-        gomocup_game_info_command(*eo[i], o, engines[i]);
+        gomocup_game_info_command(*eo[i], o, *engines[i]);
     }
 
     // init time control
@@ -212,8 +270,8 @@ int Game::play(const Options       &o,
 
     // Determine which eo/timeLeft index corresponds to Black.
     // engines are loaded with reverse: engines[i] = eo[reverse ? 1-i : i]
-    // eo index for Black engine = pos[0].get_turn() (works for any opening stone count)
-    const int blackEo = pos[0].get_turn();
+    // eo index for Black engine = pos.get_turn() (works for any opening stone count)
+    const int blackEo = pos.get_turn();
 
     // Report initial time
     if (onTimeUpdate) {
@@ -222,21 +280,21 @@ int Game::play(const Options       &o,
 
     for (ply = 0;; ei = (1 - ei), ply++) {
         if (played != NONE_MOVE) {
-            pos[ply].move_with_copy(pos[ply - 1], played);
+            pos.move(played);
 
             // Notify GUI of the new position
-            if (onMove) onMove(pos[ply]);
+            if (onMove) onMove(pos);
         }
         else if (ply == 0 && onMove) {
             // Notify GUI of the opening position
-            onMove(pos[0]);
+            onMove(pos);
         }
 
         if (o.debug) {
-            pos[ply].print();
+            pos.print();
         }
 
-        state = game_apply_rules(played);
+        state = game_apply_rules(o.ruleCheck);
         if (state > STATE_NONE) {
             break;
         }
@@ -247,8 +305,24 @@ int Game::play(const Options       &o,
             break;
         }
 
+        // Apply solved position adjudication: the result is known from an earlier game
+        int solvedResult;
+        if (solvedCache && ply > 0
+            && solvedCache->probe(SolvedCache::key(pos, game_rule), solvedResult)) {
+            state = solvedResult == RESULT_WIN    ? STATE_SOLVED_WIN
+                    : solvedResult == RESULT_LOSS ? STATE_SOLVED_LOSS
+                                                  : STATE_SOLVED_DRAW;
+            break;
+        }
+
+        // Apply VCF adjudication rule: the side to move has a forced win
+        if (vcf && ply > 0 && vcf->solve(pos)) {
+            state = STATE_VCF_WIN;
+            break;
+        }
+
         // Apply force draw adjudication rule
-        if (o.forceDrawAfter && pos[ply].get_move_count() >= o.forceDrawAfter) {
+        if (o.forceDrawAfter && pos.get_move_count() >= o.forceDrawAfter) {
             state = STATE_DRAW_ADJUDICATION;
             break;
         }
@@ -257,44 +331,45 @@ int Game::play(const Options       &o,
         compute_time_left(*eo[ei], timeLeft[ei]);
 
         // output game/turn info
-        gomocup_turn_info_command(*eo[ei], timeLeft[ei], engines[ei]);
+        gomocup_turn_info_command(*eo[ei], timeLeft[ei], *engines[ei]);
 
         // Report time update
         if (onTimeUpdate) onTimeUpdate(timeLeft[blackEo], timeLeft[1 - blackEo]);
 
         // trigger think!
-        if (pos[ply].get_move_count() == 0) {
-            engines[ei].writeln("BEGIN");
+        if (pos.get_move_count() == 0) {
+            engines[ei]->writeln("BEGIN");
             canUseTurn[ei] = true;
         }
         else {
             if (o.useTURN && canUseTurn[ei]) {  // use TURN to trigger think
-                engines[ei].writeln(
-                    format("TURN %s", pos[ply].move_to_gomostr(played)).c_str());
+                char cmd[32] = "TURN ";
+                pos.move_to_gomostr(played, cmd + 5, sizeof(cmd) - 5);
+                engines[ei]->writeln(cmd);
             }
             else {  // use BOARD to trigger think
-                send_board_command(pos[ply], engines[ei]);
+                send_board_command(pos, *engines[ei]);
                 canUseTurn[ei] = true;
             }
         }
 
         std::string bestmove;
         Info        moveInfo = {};
-        const bool  ok       = engines[ei].bestmove(timeLeft[ei],
-                                             eo[ei]->timeoutTurn,
-                                             bestmove,
-                                             moveInfo,
-                                             pos[ply].get_move_count() + 1);
+        const bool  ok       = engines[ei]->bestmove(timeLeft[ei],
+                                              eo[ei]->timeoutTurn,
+                                              bestmove,
+                                              moveInfo,
+                                              pos.get_move_count() + 1);
         this->info.push_back(moveInfo);
 
         if (!ok) {  // engine crashed/hard timeout in bestmove()
             DIE_OR_ERR(o.fatalError,
                        "[%d] engine %s %s at %d moves after opening\n",
                        w->id,
-                       engines[ei].name.c_str(),
-                       engines[ei].is_crashed() ? "crashed" : "timeout",
+                       engines[ei]->name.c_str(),
+                       engines[ei]->is_crashed() ? "crashed" : "timeout",
                        ply);
-            state = engines[ei].is_crashed() ? STATE_CRASHED : STATE_TIME_LOSS;
+            state = engines[ei]->is_crashed() ? STATE_CRASHED : STATE_TIME_LOSS;
             break;
         }
 
@@ -302,19 +377,19 @@ int Game::play(const Options       &o,
             && timeLeft[ei] < 0) {  // engine soft timeout in bestmove()
             printf("[%d] engine %s timeout at %d moves after opening\n",
                    w->id,
-                   engines[ei].name.c_str(),
+                   engines[ei]->name.c_str(),
                    ply);
             state = STATE_TIME_LOSS;
             break;
         }
 
-        played = pos[ply].gomostr_to_move(bestmove);
+        played = pos.gomostr_to_move(bestmove);
 
         // Check if move is legal
-        if (!pos[ply].is_legal_move(played)) {
+        if (!pos.is_legal_move(played)) {
             printf("[%d] engine %s output illegal move at %d moves after opening: %s\n",
                    w->id,
-                   engines[ei].name.c_str(),
+                   engines[ei]->name.c_str(),
                    ply,
                    bestmove.c_str());
             state = STATE_ILLEGAL_MOVE;
@@ -322,8 +397,7 @@ int Game::play(const Options       &o,
         }
 
         // Check forbidden move for Renju rule
-        if (game_rule == RENJU
-            && (forbidden_type = pos[ply].check_forbidden_move(played))) {
+        if ((forbidden_type = rules->forbidden(pos, played))) {
             state = STATE_FORBIDDEN_MOVE;
             break;
         }
@@ -350,10 +424,24 @@ int Game::play(const Options       &o,
             resignCount[ei] = 0;
         }
 
+        // Apply consensus adjudication rule: both engines agree on the winner, for count
+        // move pairs in a row (a run of agreeing scores starts with the previous ply)
+        if (o.consensus.count && info.size() >= 2
+            && scores_agree(info[info.size() - 2].score, moveInfo.score, o.consensus)) {
+            consensusPlies = consensusPlies ? consensusPlies + 1 : 2;
+            if (consensusPlies >= 2 * o.consensus.count) {
+                state = moveInfo.score > 0 ? STATE_CONSENSUS_WIN : STATE_CONSENSUS_LOSS;
+                break;
+            }
+        }
+        else {
+            consensusPlies = 0;
+        }
+
         // Write sample: position (compactly encoded) + move
         if (!o.sp.fileName.empty() && prngf(w->seed) <= o.sp.freq) {
             Sample sample = {
-                .pos    = pos[ply],
+                .pos    = pos,
                 .move   = played,
                 .result = NB_RESULT,  // mark as invalid for now, computed after the game
                 // saturated evaluation score return from the engine
@@ -363,12 +451,18 @@ int Game::play(const Options       &o,
             // Record sample.
             samples.push_back(sample);
         }
-
-        pos.emplace_back();
     }
 
     assert(state != STATE_NONE);
 
+    // Lines queued since the last read (game info, or a move the opponent never read)
+    // must not reach the engine with the next game
+    for (int i = 0; i < 2; i++)
+        engines[i]->flush();
+
+    if (solvedCache)
+        record_solved(o.solved.plies);
+
     // Fill results in samples
     if (state == STATE_TIME_LOSS || state == STATE_CRASHED
         || state == STATE_ILLEGAL_MOVE) {
@@ -378,8 +472,11 @@ int Game::play(const Options       &o,
         // Signed result from white's pov: 0 (loss), 1 (draw), 2 (win)
         const int wpov =
             state < STATE_SEPARATOR
-                ? (pos[ply].get_turn() == WHITE ? RESULT_LOSS
-                                                : RESULT_WIN)  // lost from turn's pov
+                ? (pos.get_turn() == WHITE ? RESULT_LOSS
+                                           : RESULT_WIN)  // lost from turn's pov
+            : state > STATE_WIN_SEPARATOR
+                ? (pos.get_turn() == WHITE ? RESULT_WIN
+                                           : RESULT_LOSS)  // won from turn's pov
                 : RESULT_DRAW;
 
         for (size_t i = 0; i < samples.size(); i++)
@@ -388,9 +485,33 @@ int Game::play(const Options       &o,
 
     return state < STATE_SEPARATOR
                ? (ei == 0 ? RESULT_LOSS : RESULT_WIN)  // engine on the move has lost
+           : state > STATE_WIN_SEPARATOR
+               ? (ei == 0 ? RESULT_WIN : RESULT_LOSS)  // engine on the move has won
                : RESULT_DRAW;
 }
 
+// Feeds the solved position cache with the positions this game has solved: the last one
+// for a proof by adjudication, and the ones up to plies before a five (beyond the first,
+// taken on trust). Games ended by time loss, crash, consensus or resignation prove
+// nothing, and store nothing.
+void Game::record_solved(int plies)
+{
+    if (state == STATE_VCF_WIN)
+        solvedCache->store(SolvedCache::key(pos, game_rule), RESULT_WIN);
+    else if (state == STATE_DRAW_DEAD_POSITION)
+        solvedCache->store(SolvedCache::key(pos, game_rule), RESULT_DRAW);
+    else if (state == STATE_FIVE_CONNECT) {
+        Position before = pos;
+        int      result = RESULT_LOSS;  // from the pov of the side to move
+
+        for (int i = 0; i < plies && before.get_move_count() > openingPly; i++) {
+            before.undo();
+            result = 2 - result;
+            solvedCache->store(SolvedCache::key(before, game_rule), result);
+        }
+    }
+}
+
 void Game::decode_state(std::string &result,
                         std::string &reason,
                         const char  *restxt[3]) const
@@ -402,7 +523,7 @@ void Game::decode_state(std::string &result,
     // and next side to move is <color>, then the side of win is opponent(<color>),
     // which is last moved side
 
-    bool isBlackTurn = pos[ply].get_turn() == BLACK;
+    bool isBlackTurn = pos.get_turn() == BLACK;
 
     if (state == STATE_NONE) {
         result = "*";
@@ -435,14 +556,40 @@ void Game::decode_state(std::string &result,
     }
     else if (state == STATE_DRAW_ADJUDICATION)
         reason = "Draw by adjudication";
+    else if (state == STATE_DRAW_DEAD_POSITION)
+        reason = "Draw by dead position";
+    else if (state == STATE_SOLVED_DRAW)
+        reason = "Draw by solved position";
     else if (state == STATE_RESIGN) {
         result = isBlackTurn ? restxt[RESULT_LOSS] : restxt[RESULT_WIN];
         reason = isBlackTurn ? "White win by adjudication" : "Black win by adjudication";
     }
+    else if (state == STATE_CONSENSUS_LOSS) {
+        result = isBlackTurn ? restxt[RESULT_LOSS] : restxt[RESULT_WIN];
+        reason = isBlackTurn ? "White win by consensus" : "Black win by consensus";
+    }
+    else if (state == STATE_CONSENSUS_WIN) {
+        result = isBlackTurn ? restxt[RESULT_WIN] : restxt[RESULT_LOSS];
+        reason = isBlackTurn ? "Black win by consensus" : "White win by consensus";
+    }
     else if (state == STATE_TIME_LOSS) {
         result = isBlackTurn ? restxt[RESULT_LOSS] : restxt[RESULT_WIN];
         reason = isBlackTurn ? "White win by time forfeit" : "Black win by time forfeit";
     }
+    else if (state == STATE_SOLVED_LOSS) {
+        result = isBlackTurn ? restxt[RESULT_LOSS] : restxt[RESULT_WIN];
+        reason = isBlackTurn ? "White win by solved position"
+                             : "Black win by solved position";
+    }
+    else if (state == STATE_SOLVED_WIN) {
+        result = isBlackTurn ? restxt[RESULT_WIN] : restxt[RESULT_LOSS];
+        reason = isBlackTurn ? "Black win by solved position"
+                             : "White win by solved position";
+    }
+    else if (state == STATE_VCF_WIN) {
+        result = isBlackTurn ? restxt[RESULT_WIN] : restxt[RESULT_LOSS];
+        reason = isBlackTurn ? "Black win by VCF" : "White win by VCF";
+    }
     else if (state == STATE_CRASHED) {
         result = isBlackTurn ? restxt[RESULT_LOSS] : restxt[RESULT_WIN];
         reason =
@@ -517,7 +664,7 @@ std::string Game::export_sgf(size_t gameIdx) const
     out.push_back('\n');
 
     // Print the moves
-    const Position &lastPos = pos[ply];
+    const Position &lastPos = pos;
 
     // openning moves
     int openingMoveCnt = lastPos.get_move_count() - ply;
@@ -569,13 +716,30 @@ std::string Game::export_sgf(size_t gameIdx) const
     return out;
 }
 
-void Game::export_samples_csv(FILE *out) const
+void Game::export_samples_csv(FILE *out, bool features) const
 {
+    // Threat features of all the samples at once, as extra columns: the count of each
+    // ThreatType for black, then for white
+    std::vector<ThreatFeatures> threats;
+    if (features) {
+        std::vector<const Position *> positions;
+        for (const Sample &sample : samples)
+            positions.push_back(&sample.pos);
+        threats.resize(samples.size());
+        Position::threat_features(positions.data(), positions.size(), game_rule,
+                                  threats.data());
+    }
+
     for (size_t i = 0; i < samples.size(); i++) {
         std::string pos_str = samples[i].pos.to_opening_str(OPENING_POS);
         std::string move_str =
             samples[i].pos.move_to_opening_str(samples[i].move, OPENING_POS);
-        fprintf(out, "%s,%s,%d\n", pos_str.c_str(), move_str.c_str(), samples[i].result);
+        fprintf(out, "%s,%s,%d", pos_str.c_str(), move_str.c_str(), samples[i].result);
+        if (features)
+            for (int c = BLACK; c <= WHITE; c++)
+                for (int t = 0; t < NB_THREAT; t++)
+                    fprintf(out, ",%d", threats[i].count[c][t]);
+        fputc('\n', out);
     }
 }
 
@@ -776,13 +940,13 @@ void Game::export_samples_binpack(FILE *out, LZ4F_compressionContext_t lz4Ctx) c
 }
 
 void Game::export_samples(FILE                     *out,
-                          SampleFormat              format,
+                          const SampleParams       &sp,
                           LZ4F_compressionContext_t lz4Ctx) const
 {
     FileLock fl(out);
 
-    switch (format) {
-    case SAMPLE_FORMAT_CSV: export_samples_csv(out); break;
+    switch (sp.format) {
+    case SAMPLE_FORMAT_CSV: export_samples_csv(out, sp.features); break;
     case SAMPLE_FORMAT_BIN: export_samples_bin(out, lz4Ctx); break;
     case SAMPLE_FORMAT_BINPACK: export_samples_binpack(out, lz4Ctx); break;
     }
@@ -19,6 +19,7 @@
 #include "extern/lz4frame.h"
 #include "options.h"
 #include "position.h"
+#include "solvedcache.h"
 
 #include <functional>
 #include <string>
@@ -38,12 +39,23 @@ enum {
     STATE_ILLEGAL_MOVE,    // lost by playing an illegal move
     STATE_FORBIDDEN_MOVE,  // lost by playing on a forbidden position
     STATE_RESIGN,          // resigned on behalf of the engine
+    STATE_CONSENSUS_LOSS,  // both engines agree that the side to move loses
+    STATE_SOLVED_LOSS,     // lost a position solved in an earlier game
 
     STATE_SEPARATOR,  // invalid result, just a market to separate losses from draws
 
     // All possible ways to draw
     STATE_DRAW_INSUFFICIENT_SPACE,  // draw due to insufficien empty position on board
-    STATE_DRAW_ADJUDICATION         // draw by adjudication
+    STATE_DRAW_ADJUDICATION,        // draw by adjudication
+    STATE_DRAW_DEAD_POSITION,       // draw as no five can be made any more
+    STATE_SOLVED_DRAW,              // drawn position solved in an earlier game
+
+    STATE_WIN_SEPARATOR,  // marker to separate draws from wins
+
+    // All possible ways to win (for the side to move)
+    STATE_VCF_WIN,        // won by a proven victory by continuous fours
+    STATE_SOLVED_WIN,     // won a position solved in an earlier game
+    STATE_CONSENSUS_WIN,  // both engines agree that the side to move wins
 };
 
 struct Sample
@@ -58,12 +70,14 @@ class Game
 {
 public:
     std::string           names[NB_COLOR];  // names of players, by color
-    std::vector<Position> pos;   // list of positions (including moves) since game start
+    Position              pos;   // current position (including moves) since game start
     std::vector<Info>     info;  // remembered from parsing info lines (for PGN comments)
     std::vector<Sample>   samples;    // list of samples when generating training data
     GameRule              game_rule;  // rule is gomoku or renju, etc
+    const RuleKernel     *rules;      // rule checks specialised for the size and rule
     ForbiddenType         forbidden_type;  // forbidden type of the last move (in renju)
     int                   round, game, ply, state, board_size;
+    int                   openingPly;  // number of stones in the opening position
     Worker *const         w;
 
     // Optional callback invoked after each move with the current position
@@ -72,6 +86,8 @@ public:
     std::function<void(int64_t, int64_t)> onTimeUpdate;
     // Optional callback to check if game should be aborted
     std::function<bool()> shouldAbort;
+    // Optional tournament-wide cache of solved positions (looked up and fed by play())
+    SolvedCache *solvedCache;
 
     Game(int round, int game, Worker *worker);
 
@@ -80,18 +96,19 @@ public:
                       size_t           currentRound,
                       Color           &color);
     int
-    play(const Options &o, Engine engines[2], const EngineOptions *eo[2], bool reverse);
+    play(const Options &o, Engine *engines[2], const EngineOptions *eo[2], bool reverse);
 
     void
     decode_state(std::string &result, std::string &reason, const char *restxt[3]) const;
     std::string export_pgn(size_t gameIdx) const;
     std::string export_sgf(size_t gameIdx) const;
     void        export_samples(FILE                     *out,
-                               SampleFormat              format,
+                               const SampleParams       &sp,
                                LZ4F_compressionContext_t lz4Ctx = nullptr) const;
 
 private:
-    int  game_apply_rules(move_t lastmove);
+    int  game_apply_rules(bool ruleCheck);
+    void record_solved(int plies);
     void compute_time_left(const EngineOptions &eo, int64_t &timeLeft);
     void send_board_command(const Position &position, Engine &engine);
     void gomocup_turn_info_command(const EngineOptions &eo,
@@ -100,7 +117,7 @@ private:
     void gomocup_game_info_command(const EngineOptions &eo,
                                    const Options       &option,
                                    Engine              &engine);
-    void export_samples_csv(FILE *out) const;
+    void export_samples_csv(FILE *out, bool features) const;
     void export_samples_bin(FILE *out, LZ4F_compressionContext_t lz4Ctx) const;
     void export_samples_binpack(FILE *out, LZ4F_compressionContext_t lz4Ctx) const;
 };
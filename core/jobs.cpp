@@ -132,7 +132,7 @@ void JobQueue::set_name(int ei, std::string_view name)
         names[ei] = name;
 }
 
-void JobQueue::print_results(size_t frequency)
+void JobQueue::print_results(size_t frequency, std::string_view extra)
 {
     std::lock_guard lock(mtx);
 
@@ -177,6 +177,7 @@ void JobQueue::print_results(size_t frequency)
                           etaSecond);
         }
 
+        out += extra;
         fputs(out.c_str(), stdout);
     }
 }
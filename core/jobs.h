@@ -51,7 +51,7 @@ public:
     void stop();
 
     void set_name(int ei, std::string_view name);
-    void print_results(size_t frequency);
+    void print_results(size_t frequency, std::string_view extra = {});
 
 public:
     std::mutex               mtx;
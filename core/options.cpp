@@ -103,6 +103,7 @@ void Options::to_json(std::ostream& os) const {
     os << "  \"games\": " << games << ",\n";
     os << "  \"rounds\": " << rounds << ",\n";
     os << "  \"concurrency\": " << concurrency << ",\n";
+    os << "  \"threads\": " << threads << ",\n";
     os << "  \"boardSize\": " << boardSize << ",\n";
     os << "  \"openings\": " << json_escape(openings) << ",\n";
     os << "  \"gameRule\": " << (int)gameRule << ",\n";
@@ -112,11 +113,22 @@ void Options::to_json(std::ostream& os) const {
     os << "  \"resignCount\": " << resignCount << ",\n";
     os << "  \"resignScore\": " << resignScore << ",\n";
     os << "  \"forceDrawAfter\": " << forceDrawAfter << ",\n";
+    os << "  \"vcfNodes\": " << vcf.nodes << ",\n";
+    os << "  \"vcfTime\": " << vcf.time << ",\n";
+    os << "  \"vcfDepth\": " << vcf.depth << ",\n";
+    os << "  \"consensusCount\": " << consensus.count << ",\n";
+    os << "  \"consensusMate\": " << consensus.mate << ",\n";
+    os << "  \"consensusScore\": " << consensus.score << ",\n";
+    os << "  \"solvedSize\": " << solved.sizeMB << ",\n";
+    os << "  \"solvedPlies\": " << solved.plies << ",\n";
+    os << "  \"poolIdle\": " << pool.idle << ",\n";
+    os << "  \"poolMemory\": " << pool.memoryMB << ",\n";
     os << "  \"random\": " << (random ? "true" : "false") << ",\n";
     os << "  \"useTURN\": " << (useTURN ? "true" : "false") << ",\n";
     os << "  \"pgn\": " << json_escape(pgn) << ",\n";
     os << "  \"sgf\": " << json_escape(sgf) << ",\n";
     os << "  \"msg\": " << json_escape(msg) << ",\n";
+    os << "  \"aboutCache\": " << json_escape(aboutCache) << ",\n";
     os << "  \"fatalError\": " << (fatalError ? "true" : "false") << "\n";
     os << "}";
 }
@@ -135,6 +147,7 @@ void Options::from_json(std::istream& is) {
         if (key == "games") games = parse_int(is);
         else if (key == "rounds") rounds = parse_int(is);
         else if (key == "concurrency") concurrency = parse_int(is);
+        else if (key == "threads") threads = parse_int(is);
         else if (key == "boardSize") boardSize = parse_int(is);
         else if (key == "openings") openings = parse_string(is);
         else if (key == "gameRule") { int v = parse_int(is); gameRule = (GameRule)v; }
@@ -144,11 +157,22 @@ void Options::from_json(std::istream& is) {
         else if (key == "resignCount") resignCount = parse_int(is);
         else if (key == "resignScore") resignScore = parse_int(is);
         else if (key == "forceDrawAfter") forceDrawAfter = parse_int(is);
+        else if (key == "vcfNodes") vcf.nodes = parse_int(is);
+        else if (key == "vcfTime") vcf.time = parse_int(is);
+        else if (key == "vcfDepth") vcf.depth = parse_int(is);
+        else if (key == "consensusCount") consensus.count = parse_int(is);
+        else if (key == "consensusMate") consensus.mate = parse_int(is);
+        else if (key == "consensusScore") consensus.score = parse_int(is);
+        else if (key == "solvedSize") solved.sizeMB = parse_int(is);
+        else if (key == "solvedPlies") solved.plies = parse_int(is);
+        else if (key == "poolIdle") pool.idle = parse_int(is);
+        else if (key == "poolMemory") pool.memoryMB = parse_int(is);
         else if (key == "random") random = parse_bool(is);
         else if (key == "useTURN") useTURN = parse_bool(is);
         else if (key == "pgn") pgn = parse_string(is);
         else if (key == "sgf") sgf = parse_string(is);
         else if (key == "msg") msg = parse_string(is);
+        else if (key == "aboutCache") aboutCache = parse_string(is);
         else if (key == "fatalError") fatalError = parse_bool(is);
         else {
             Options::skip_json_value(is);
@@ -171,6 +195,10 @@ void EngineOptions::to_json(std::ostream& os) const {
     os << "  \"numThreads\": " << numThreads << ",\n";
     os << "  \"maxMemory\": " << maxMemory << ",\n";
     os << "  \"tolerance\": " << tolerance << ",\n";
+    os << "  \"outputLines\": " << output.lines << ",\n";
+    os << "  \"outputBytes\": " << output.bytes << ",\n";
+    os << "  \"outputMessage\": " << (int)output.message << ",\n";
+    os << "  \"outputPlain\": " << (int)output.plain << ",\n";
     
     os << "  \"options\": [";
     for (size_t i = 0; i < options.size(); i++) {
@@ -202,6 +230,10 @@ void EngineOptions::from_json(std::istream& is) {
         else if (key == "numThreads") numThreads = parse_int(is);
         else if (key == "maxMemory") maxMemory = parse_int64(is);
         else if (key == "tolerance") tolerance = parse_int64(is);
+        else if (key == "outputLines") output.lines = parse_int(is);
+        else if (key == "outputBytes") output.bytes = parse_int64(is);
+        else if (key == "outputMessage") output.message = (OutputMode)parse_int(is);
+        else if (key == "outputPlain") output.plain = (OutputMode)parse_int(is);
         else if (key == "options") {
             options.clear();
             skip_ws(is);
@@ -15,6 +15,7 @@
  */
 
 #pragma once
+#include "engineoutput.h"
 #include "position.h"
 #include "sprt.h"
 
@@ -30,32 +31,73 @@ struct SampleParams
     double       freq     = 1.0;
     SampleFormat format   = SAMPLE_FORMAT_CSV;
     bool         compress = false;
+    bool         features = false;  // append threat counts of both colours (csv only)
+};
+
+// VCF adjudication: after each move, a bounded search for a win by continuous fours
+struct VcfParams
+{
+    int64_t nodes = 0;   // node budget of each search (0 disables the adjudication)
+    int64_t time  = 0;   // time budget of each search in ms (0 for none)
+    int     depth = 30;  // longest sequence of fours searched
+};
+
+// Consensus adjudication: the game ends when both engines, on consecutive moves, agree
+// on the winner with mate scores (or, optionally, plain scores beyond a threshold)
+struct ConsensusParams
+{
+    int count = 0;  // consecutive agreeing move pairs needed (0 disables it)
+    int mate  = 2;  // largest difference between the two mate distances
+    int score = 0;  // plain score threshold (0 for mate scores only)
+};
+
+// Engine pool: idle engine processes kept across pair changes, instead of restarting them
+struct PoolParams
+{
+    int    idle     = 0;  // idle processes kept per engine (0 disables the pool)
+    size_t memoryMB = 0;  // resident memory budget of all idle processes (0 for none)
+};
+
+// Solved position cache: results of positions solved in earlier games of the tournament
+struct SolvedParams
+{
+    size_t sizeMB = 0;  // cache size (0 disables it)
+    // positions kept before a five: only 1 is a proof, beyond that the result trusts
+    // the engines' play (the loser walked into the five)
+    int    plies  = 1;
 };
 
 struct Options
 {
-    std::string  openings, pgn, sgf, msg;
-    SampleParams sp;
-    SPRTParam    sprtParam   = {.elo0 = 0, .elo1 = 0, .alpha = 0.05, .beta = 0.05};
-    uint64_t     srand       = 0;
-    int          concurrency = 1;
-    int          games = 1, rounds = 1;
-    int          resignCount = 0, resignScore = 0;
-    int          drawCount = 0, drawScore = 0;
-    int          forceDrawAfter = 0;
-    int          boardSize      = 15;
-    GameRule     gameRule       = GOMOKU_FIVE_OR_MORE;
-    OpeningType  openingType    = OPENING_OFFSET;
-    bool         useTURN        = true;
-    bool         log            = false;
-    bool         random         = false;
-    bool         repeat         = false;
-    bool         transform      = false;
-    bool         sprt           = false;
-    bool         gauntlet       = false;
-    bool         saveLoseOnly   = false;
-    bool         fatalError     = false;
-    bool         debug          = false;
+    std::string     openings, pgn, sgf, msg;
+    std::string     aboutCache;  // file caching the ABOUT answers of engines (optional)
+    SampleParams    sp;
+    VcfParams       vcf;
+    ConsensusParams consensus;
+    SolvedParams    solved;
+    PoolParams      pool;
+    SPRTParam       sprtParam   = {.elo0 = 0, .elo1 = 0, .alpha = 0.05, .beta = 0.05};
+    uint64_t        srand       = 0;
+    int             concurrency = 1;
+    int             threads     = 0;  // threads running the games (0 for one per game)
+    int             games = 1, rounds = 1;
+    int             resignCount = 0, resignScore = 0;
+    int             drawCount = 0, drawScore = 0;
+    int             forceDrawAfter = 0;
+    int             boardSize      = 15;
+    GameRule        gameRule       = GOMOKU_FIVE_OR_MORE;
+    OpeningType     openingType    = OPENING_OFFSET;
+    bool            useTURN        = true;
+    bool            log            = false;
+    bool            random         = false;
+    bool            repeat         = false;
+    bool            transform      = false;
+    bool            sprt           = false;
+    bool            gauntlet       = false;
+    bool            saveLoseOnly   = false;
+    bool            fatalError     = false;
+    bool            debug          = false;
+    bool            ruleCheck      = false;  // cross-check fast rule paths by full scans
 
     // Minimal JSON serialization
     void to_json(std::ostream& os) const;
@@ -85,6 +127,9 @@ struct EngineOptions
     // default tolerance is 3
     int64_t tolerance = 3000;
 
+    // thinking output handled (no limit by default)
+    OutputBudget output;
+
     // Minimal JSON serialization
     void to_json(std::ostream& os) const;
     void from_json(std::istream& is);
@@ -0,0 +1,160 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pattern.h"
+
+#include <algorithm>
+
+namespace {
+
+enum Cell : int8_t { OTHER, OWN, FREE };
+
+// The 11 cells of a line centred on the cell being checked, which holds an own stone.
+// Cells past the window read as OTHER: the classification never depends on them.
+struct Line
+{
+    int8_t cells[11];
+
+    int  at(int i) const { return i < -5 || i > 5 ? int(OTHER) : cells[i + 5]; }
+    void set(int i, Cell c) { cells[i + 5] = c; }
+
+    int below(int i) const
+    {
+        int n = 0;
+        while (at(i - 1 - n) == OWN)
+            n++;
+        return n;
+    }
+    int above(int i) const
+    {
+        int n = 0;
+        while (at(i + 1 + n) == OWN)
+            n++;
+        return n;
+    }
+    // length of the run through i, counting i as an own stone
+    int run(int i) const { return 1 + below(i) + above(i); }
+};
+
+enum OpenFourType { OF_NONE, OF_TRUE /*_OOOO_*/, OF_LONG /*O_OOO_O*/ };
+
+// Four and open four on the line, for the own stone at i: walk over own stones (at
+// most four in total) to the first cell on each side, which must be empty and make
+// exactly five.
+bool isFour(const Line &l, int i)
+{
+    const int lo = std::min(l.below(i), 4);
+    const int ro = std::min(l.above(i), 4 - lo);
+
+    if (lo < 4 && l.at(i - lo - 1) == FREE && l.run(i - lo - 1) == 5)
+        return true;
+    if (ro < 4 - lo && l.at(i + ro + 1) == FREE && l.run(i + ro + 1) == 5)
+        return true;
+    return false;
+}
+
+OpenFourType isOpenFour(const Line &l, int i)
+{
+    const int lo = std::min(l.below(i), 4);
+    const int ro = std::min(l.above(i), 4 - lo);
+
+    if (lo == 4 || l.at(i - lo - 1) != FREE || l.run(i - lo - 1) != 5)
+        return OF_NONE;
+    if (ro == 4 - lo || l.at(i + ro + 1) != FREE || l.run(i + ro + 1) != 5)
+        return OF_NONE;
+
+    return lo + ro + 1 == 4 ? OF_TRUE : OF_LONG;
+}
+
+// Spots that make five or more with the centre stone, for rules where an overline wins:
+// the first cell past the run of the centre on each side
+int longFiveSpots(const Line &l)
+{
+    const int lo = l.below(0), ro = l.above(0);
+    return (l.at(-lo - 1) == FREE && l.run(-lo - 1) >= 5)
+           + (l.at(ro + 1) == FREE && l.run(ro + 1) >= 5);
+}
+
+// Empty cell i would make a straight four together with the centre stone
+bool makesOpenFour(const Line &l, int i)
+{
+    Line withStone = l;
+    withStone.set(i, OWN);
+    return isOpenFour(withStone, i) == OF_TRUE;
+}
+
+LinePattern classify(const Line &l)
+{
+    LinePattern p = {};
+    const int   n = l.run(0);
+
+    p.five     = n == 5;
+    p.overline = n >= 6;
+
+    const OpenFourType of = isOpenFour(l, 0);
+    p.fours               = of == OF_LONG ? 2 : isFour(l, 0) ? 1 : 0;
+    p.openFour            = of == OF_TRUE;
+    p.longFours           = longFiveSpots(l);
+
+    // A three is a line where one of the nearest non-own cells on either side can
+    // make a straight four (whether that spot is itself playable is decided by the
+    // caller, with the stone put on the centre)
+    int i, j;
+    for (i = 1; i < 5; i++) {
+        if (l.at(-i) == OWN)
+            continue;
+        if (l.at(-i) == FREE && makesOpenFour(l, -i))
+            p.threeLow = i;
+        break;
+    }
+    for (j = 1; j < 6 - i; j++) {
+        if (l.at(j) == OWN)
+            continue;
+        if (l.at(j) == FREE && makesOpenFour(l, j))
+            p.threeHigh = j;
+        break;
+    }
+
+    return p;
+}
+
+}  // namespace
+
+PatternTable::PatternTable()
+{
+    for (int b = 0; b < 1024; b++) {
+        int v = 0;
+        for (int bit = 9; bit >= 0; bit--)
+            v = v * 3 + ((b >> bit) & 1);
+        base3[b] = v;
+    }
+
+    // Key digits follow the window bits: digit d is the cell at offset d - 5 for
+    // d < 5, and d - 4 otherwise
+    for (int key = 0; key < KeyCount; key++) {
+        Line l;
+        l.set(0, OWN);
+        for (int d = 0, k = key; d < 10; d++, k /= 3)
+            l.set(d < 5 ? d - 5 : d - 4, Cell(k % 3));
+        patterns[key] = classify(l);
+    }
+}
+
+const PatternTable &PatternTable::get()
+{
+    static const PatternTable table;
+    return table;
+}
@@ -0,0 +1,65 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Renju classification of one line through an empty cell, as if a stone of the side
+// being checked was put on it. Everything the referee needs to know about a line
+// only depends on the 5 cells on each side of the cell, so a line is looked up by
+// the state of these 10 cells (own stone, empty, or anything else).
+struct LinePattern
+{
+    uint16_t five : 1;       // exactly five in a row
+    uint16_t overline : 1;   // six or more in a row
+    uint16_t fours : 2;      // fours made on this line (2 for O_OOO_O and the like)
+    uint16_t openFour : 1;   // a straight four (counted as one of the fours)
+    uint16_t longFours : 2;  // spots making five or more, when long connections win
+    uint16_t threeLow : 3;   // distance below the cell of the spot that would turn a
+    uint16_t threeHigh : 3;  // three into a straight four (0 = none), same above
+};
+
+class PatternTable
+{
+public:
+    static const int KeyCount = 59049;  // 3^10
+
+    // The table is built once, on first use
+    static const PatternTable &get();
+
+    const LinePattern &operator[](int key) const { return patterns[key]; }
+
+    // Key of the line word around bit k, from the bits set for own stones and for
+    // empty cells (any other bit is an opponent stone or out of the board)
+    int key(uint32_t own, uint32_t empty, int k) const
+    {
+        return base3[window(own, k)] + 2 * base3[window(empty, k)];
+    }
+
+private:
+    PatternTable();
+
+    // the 5 bits below and the 5 bits above bit k, packed into 10 bits
+    static int window(uint32_t b, int k)
+    {
+        const uint32_t w = (b >> (k - 5)) & 0x7FF;
+        return (w & 0x1F) | (w >> 6 << 5);
+    }
+
+    uint16_t    base3[1024];  // binary digits read in base 3
+    LinePattern patterns[KeyCount];
+};
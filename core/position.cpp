@@ -16,15 +16,19 @@
 
 #include "position.h"
 
+#include "codec.h"
 #include "util.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <cstddef>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <type_traits>
 
 typedef int16_t Direction;
 const Direction DIRECTION[4] = {1,
@@ -53,6 +57,33 @@ inline Color opponent_color(Color c)
     return OPPSITE_COLOR[c];
 }
 
+// Zobrist keys for each board size, generated from a fixed seed so that keys are
+// identical across runs, threads and machines
+struct ZobristTable
+{
+    uint64_t piece[Position::RealBoardSize + 1][NB_COLOR][Position::MaxBoardSizeSqr];
+    uint64_t empty[Position::RealBoardSize + 1];  // empty board of that size
+    uint64_t side[Position::RealBoardSize + 1];   // white to move
+
+    ZobristTable()
+    {
+        for (int size = 0; size <= Position::RealBoardSize; size++) {
+            uint64_t seed = 0x5A0B1C2D3E4F6071ULL + size;
+            for (int c = 0; c < NB_COLOR; c++)
+                for (int p = 0; p < Position::MaxBoardSizeSqr; p++)
+                    piece[size][c][p] = prng(seed);
+            empty[size] = prng(seed);
+            side[size]  = prng(seed);
+        }
+    }
+};
+
+static const ZobristTable &zobrist()
+{
+    static const ZobristTable table;
+    return table;
+}
+
 inline Pos transformPos(Pos p, int boardsize, TransformType type)
 {
     int x = CoordX(p), y = CoordY(p);
@@ -76,12 +107,39 @@ inline Pos transformPos(Pos p, int boardsize, TransformType type)
     }
 }
 
+// Cell permutation of each transform, for each board size (cells out of the board are
+// left in place)
+struct TransformTable
+{
+    Pos perm[Position::RealBoardSize + 1][NB_TRANS][Position::MaxBoardSizeSqr];
+
+    TransformTable()
+    {
+        for (int size = 1; size <= Position::RealBoardSize; size++)
+            for (int t = 0; t < NB_TRANS; t++)
+                for (int p = 0; p < Position::MaxBoardSizeSqr; p++) {
+                    const bool inBoard = CoordX(p) >= 0 && CoordX(p) < size
+                                         && CoordY(p) >= 0 && CoordY(p) < size;
+                    perm[size][t][p] = inBoard ? transformPos(p, size, (TransformType)t) : p;
+                }
+    }
+};
+
+static const TransformTable &transforms()
+{
+    static const TransformTable table;
+    return table;
+}
+
 void Position::initBoard(int size)
 {
     boardSize    = size;
     boardSizeSqr = boardSize * boardSize;
     moveCount    = 0;
     playerToMove = BLACK;
+    zobristKey   = zobrist().empty[size];
+    bitBoard.clear();
+    resetOpenWindows();
     for (int i = 0; i < MaxBoardSizeSqr; i++) {
         board[i] = (CoordX(i) >= 0 && CoordX(i) < boardSize && CoordY(i) >= 0
                     && CoordY(i) < boardSize)
@@ -91,18 +149,48 @@ void Position::initBoard(int size)
     winConnectionLen = 0;
 }
 
+// Counts of the empty board: every five window is open for both sides
+void Position::resetOpenWindows()
+{
+    const uint32_t *cells = BitBoard::board_lines(boardSize);
+
+    int count = 0;
+    for (int li = 0; li < BitBoard::FirstLine[4]; li++)
+        count += __builtin_popcount(five_starts(cells[li], false));
+    openWindows[BLACK] = openWindows[WHITE] = count;
+}
+
 Position::Position(int bSize)
 {
     assert(bSize > 0 && bSize <= RealBoardSize);
     initBoard(bSize);
 }
 
+Position::Position(const Position &other)
+{
+    *this = other;
+}
+
+Position &Position::operator=(const Position &other)
+{
+    static_assert(std::is_standard_layout_v<Position>, "offsetof() needs standard layout");
+
+    // Everything up to the move history, plus the part of the history in use
+    const size_t usedSize =
+        offsetof(Position, historyMoves) + other.moveCount * sizeof(move_t);
+    if (this != &other)
+        memcpy((void *)this, &other, usedSize);
+    return *this;
+}
+
 void Position::move(move_t m)
 {
     Pos pos = PosFromMove(m);
+    assert(moveCount < boardSizeSqr);
     setPiece(pos, playerToMove);
     historyMoves[moveCount] = m;
     playerToMove            = opponent_color(playerToMove);
+    zobristKey ^= zobrist().side[boardSize];
     moveCount++;
 }
 
@@ -113,6 +201,7 @@ void Position::undo()
     Pos lastPos = PosFromMove(historyMoves[moveCount]);
     delPiece(lastPos);
     playerToMove = opponent_color(playerToMove);
+    zobristKey ^= zobrist().side[boardSize];
 }
 
 void Position::transform(TransformType type)
@@ -121,39 +210,77 @@ void Position::transform(TransformType type)
     if (type == IDENTITY)
         return;
 
-    // Clear previous board stones
-    Color tmpBoard[MaxBoardSizeSqr];
-    memcpy(tmpBoard, board, sizeof(tmpBoard));
-    for (int x = 0; x < boardSize; x++)
-        for (int y = 0; y < boardSize; y++) {
-            Pos pos = POS(x, y);
-            if (board[pos] != EMPTY)
-                delPiece(pos);  // delete prev stone if exists
-        }
+    const Pos *perm = transforms().perm[boardSize][type];
 
-    // Transform all board cells and zobrist key
-    for (int x = 0; x < boardSize; x++)
-        for (int y = 0; y < boardSize; y++) {
-            Pos pos            = POS(x, y);
-            Pos transformedPos = transformPos(pos, boardSize, type);
-            if (tmpBoard[pos] != EMPTY)
-                setPiece(transformedPos, tmpBoard[pos]);
-        }
+    // The stones on the board are the history moves: take them all off, then put
+    // them back on their transformed cells, rebuilding the zobrist key from the one of
+    // the empty board with the same side to move. A symmetry maps five windows onto
+    // five windows, so the open window counts stay as they are.
+    const ZobristTable &z = zobrist();
 
-    // Transform all history moves
+    Color pieces[RealBoardSize * RealBoardSize];
+    for (int i = 0; i < moveCount; i++) {
+        Pos pos    = PosFromMove(historyMoves[i]);
+        pieces[i]  = board[pos];
+        board[pos] = EMPTY;
+    }
+    bitBoard.clear();
+    zobristKey = z.empty[boardSize];
+    if (playerToMove == WHITE)
+        zobristKey ^= z.side[boardSize];
     for (int i = 0; i < moveCount; i++) {
-        move_t move            = historyMoves[i];
-        Pos    pos             = PosFromMove(move);
-        Color  color           = ColorFromMove(move);
-        Pos    transformedPos  = transformPos(pos, boardSize, type);
-        move_t transformedMove = buildMovePos(transformedPos, color);
-        historyMoves[i]        = transformedMove;
+        Pos to          = perm[PosFromMove(historyMoves[i])];
+        historyMoves[i] = buildMovePos(to, ColorFromMove(historyMoves[i]));
+        board[to]       = pieces[i];
+        bitBoard.set(to, pieces[i]);
+        zobristKey ^= z.piece[boardSize][pieces[i]][to];
     }
 
     // Transform all win connection
     for (int i = 0; i < winConnectionLen; i++) {
-        winConnectionPos[i] = transformPos(winConnectionPos[i], boardSize, type);
+        winConnectionPos[i] = perm[winConnectionPos[i]];
+    }
+}
+
+// The transform whose result has the smallest zobrist key, and that key
+TransformType Position::bestTransform(uint64_t &bestKey) const
+{
+    const ZobristTable &z = zobrist();
+
+    TransformType best = IDENTITY;
+    bestKey            = zobristKey;
+    for (int t = IDENTITY + 1; t < NB_TRANS; t++) {
+        const Pos *perm = transforms().perm[boardSize][t];
+
+        uint64_t key = zobristKey;
+        for (int i = 0; i < moveCount; i++) {
+            Pos pos = PosFromMove(historyMoves[i]);
+            key ^= z.piece[boardSize][board[pos]][pos]
+                   ^ z.piece[boardSize][board[pos]][perm[pos]];
+        }
+        if (key < bestKey) {
+            best    = (TransformType)t;
+            bestKey = key;
+        }
     }
+    return best;
+}
+
+// Applies the transform whose result has the smallest zobrist key, and returns it, so
+// that all symmetric variants of a position end up on the same board
+TransformType Position::canonicalize()
+{
+    uint64_t      key;
+    TransformType best = bestTransform(key);
+    transform(best);
+    return best;
+}
+
+uint64_t Position::get_canonical_key() const
+{
+    uint64_t key;
+    bestTransform(key);
+    return key;
 }
 
 // Prints the position in ASCII 'art' (for debugging)
@@ -165,8 +292,8 @@ void Position::print() const
     }
     std::cout << std::endl;
 
-    Color bd2[1024];
-    memcpy(bd2, board, 1024 * sizeof(Color));
+    Color bd2[MaxBoardSizeSqr];
+    memcpy(bd2, board, sizeof(bd2));
 
     for (int i = 0; i < winConnectionLen; i++) {
         bd2[winConnectionPos[i]] = WALL;
@@ -198,17 +325,45 @@ void Position::print() const
     std::cout << std::endl;
 }
 
+// Number of open five windows of a line that go through bit k (bit k is open itself)
+static int windowsThrough(uint32_t open, int k)
+{
+    return __builtin_popcount(five_starts(open, false) & (0x1Fu << (k - 4)));
+}
+
 void Position::setPiece(Pos pos, Color piece)
 {
     assert(isInBoard(pos));
     assert(board[pos] == EMPTY);
+
+    // the windows through pos are closed for the opponent
+    const uint32_t *cells = BitBoard::board_lines(boardSize);
+    for (int iDir = 0; iDir < 4; iDir++) {
+        const int li = BitBoard::line_index(pos, iDir);
+        openWindows[opponent_color(piece)] -= windowsThrough(
+            cells[li] & ~bitBoard.line(piece, li), BitBoard::bit_index(pos, iDir));
+    }
+
     board[pos] = piece;
+    bitBoard.set(pos, piece);
+    zobristKey ^= zobrist().piece[boardSize][piece][pos];
 }
 
 void Position::delPiece(Pos pos)
 {
     assert(isInBoard(pos));
     assert(board[pos] == WHITE || board[pos] == BLACK);
+    bitBoard.del(pos, board[pos]);
+    zobristKey ^= zobrist().piece[boardSize][board[pos]][pos];
+
+    // and open again for the opponent
+    const uint32_t *cells = BitBoard::board_lines(boardSize);
+    for (int iDir = 0; iDir < 4; iDir++) {
+        const int li = BitBoard::line_index(pos, iDir);
+        openWindows[opponent_color(board[pos])] += windowsThrough(
+            cells[li] & ~bitBoard.line(board[pos], li), BitBoard::bit_index(pos, iDir));
+    }
+
     board[pos] = EMPTY;
 }
 
@@ -244,10 +399,12 @@ ForbiddenType Position::check_forbidden_move(move_t move) const
     if (color != BLACK)
         return FORBIDDEN_NONE;
 
-    // Check forbidden point using recursive finder
+    // Check forbidden point using the pattern tables (the three check is recursive)
     // Note that forbidden point finder needs an empty pos to judge.
     assert(board[pos] == EMPTY);
-    return const_cast<Position *>(this)->isForbidden(pos);
+    CellPatterns patterns;
+    linePatterns(pos, BLACK, nullptr, nullptr, patterns);
+    return isForbidden(pos, patterns, nullptr);
 }
 
 void Position::check_five_helper(bool allow_long_connc,
@@ -278,59 +435,67 @@ void Position::check_five_helper(bool allow_long_connc,
 // check if there exist any line-of-n-piece-in-same-color exists for side-to-move
 // if allow_long_connection, return true if n >= 5
 // if allow_long_connection, return true if and only if n == 5
-bool Position::check_five_in_line_side(Color side, bool allow_long_connection)
-{  // const {
+template <int Size, bool AllowLong> bool Position::checkFiveSide(Color side)
+{
+    // Constant loop bounds in the kernels specialised by board size
+    const int n = Size ? Size : boardSize;
+    assert(n == boardSize);
     assert(side == WHITE || side == BLACK);
 
+    // Most positions have no five at all: reject them with the bitboard kernel,
+    // and only walk the board to locate the connection line when there is one.
+    if (!bitBoard.has_five<Size, !AllowLong>(side, boardSize))
+        return false;
+
     int i, j, k;
     int fiveCount = 0;
     Pos connectionLine[32];
 
-    for (i = 0; i < boardSize; i++) {
+    for (i = 0; i < n; i++) {
         int continueCount = 0;
-        for (j = 0; j < boardSize; j++) {
+        for (j = 0; j < n; j++) {
             Pos p = POS(i, j);
             if (board[p] == side) {
                 continueCount++;
                 connectionLine[continueCount - 1] = p;
             }
             else {
-                check_five_helper(allow_long_connection,
+                check_five_helper(AllowLong,
                                   continueCount,
                                   fiveCount,
                                   connectionLine);
                 continueCount = 0;
             }
         }
-        check_five_helper(allow_long_connection,
+        check_five_helper(AllowLong,
                           continueCount,
                           fiveCount,
                           connectionLine);
     }
 
-    for (j = 0; j < boardSize; j++) {
+    for (j = 0; j < n; j++) {
         int continueCount = 0;
-        for (i = 0; i < boardSize; i++) {
+        for (i = 0; i < n; i++) {
             Pos p = POS(i, j);
             if (board[p] == side) {
                 continueCount++;
                 connectionLine[continueCount - 1] = p;
             }
             else {
-                check_five_helper(allow_long_connection,
+                check_five_helper(AllowLong,
                                   continueCount,
                                   fiveCount,
                                   connectionLine);
                 continueCount = 0;
             }
         }
-        check_five_helper(allow_long_connection,
+        check_five_helper(AllowLong,
                           continueCount,
                           fiveCount,
                           connectionLine);
     }
 
-    for (k = -(boardSize - 1); k < boardSize; k++) {
+    for (k = -(n - 1); k < n; k++) {
         if (k <= 0) {
             i = 0;
             j = -k;
@@ -340,14 +505,14 @@ bool Position::check_five_in_line_side(Color side, bool allow_long_connection)
             j = 0;
         }
         int continueCount = 0;
-        while (isInBoard(POS(i, j))) {
+        while (i < n && j < n) {
             Pos p = POS(i, j);
             if (board[p] == side) {
                 continueCount++;
                 connectionLine[continueCount - 1] = p;
             }
             else {
-                check_five_helper(allow_long_connection,
+                check_five_helper(AllowLong,
                                   continueCount,
                                   fiveCount,
                                   connectionLine);
@@ -356,24 +521,24 @@ bool Position::check_five_in_line_side(Color side, bool allow_long_connection)
             i += 1;
             j += 1;
         }
-        check_five_helper(allow_long_connection,
+        check_five_helper(AllowLong,
                           continueCount,
                           fiveCount,
                           connectionLine);
     }
 
-    for (k = 0; k < (boardSize * 2 - 1); k++) {
-        i                 = std::min(k, boardSize - 1);
+    for (k = 0; k < (n * 2 - 1); k++) {
+        i                 = std::min(k, n - 1);
         j                 = k - i;
         int continueCount = 0;
-        while (isInBoard(POS(i, j))) {
+        while (i >= 0 && j < n) {
             Pos p = POS(i, j);
             if (board[p] == side) {
                 continueCount++;
                 connectionLine[continueCount - 1] = p;
             }
             else {
-                check_five_helper(allow_long_connection,
+                check_five_helper(AllowLong,
                                   continueCount,
                                   fiveCount,
                                   connectionLine);
@@ -382,487 +547,508 @@ bool Position::check_five_in_line_side(Color side, bool allow_long_connection)
             i -= 1;
             j += 1;
         }
-        check_five_helper(allow_long_connection,
+        check_five_helper(AllowLong,
                           continueCount,
                           fiveCount,
                           connectionLine);
     }
 
-    assert(fiveCount <= 1);
+    // Note: fiveCount can be 2 when a single move completes two lines at once,
+    // in that case the last line found is kept in winConnectionPos.
     if (fiveCount > 0) {
         return true;
     }
     return false;
 }
 
-bool Position::check_five_in_line_lastmove(bool allow_long_connection)
-{  // const {
+// check if the last move forms a line-of-n-piece-in-same-color, only looking at the
+// four lines passing through the last placed stone (same semantics as above)
+template <bool AllowLong> bool Position::checkFiveLastmove()
+{
     if (moveCount < 5) {
         return false;
     }
     Pos   lastPos   = PosFromMove(historyMoves[moveCount - 1]);
     Color lastPiece = board[lastPos];
-    return check_five_in_line_side(lastPiece, allow_long_connection);
-}
-
-move_t Position::gomostr_to_move(std::string_view movestr) const
-{
-    int    commaCount = 0;
-    size_t commaIdx   = 0;
-    for (size_t i = 0; i < movestr.length(); i++) {
-        if (movestr[i] == ',') {
-            commaIdx = i;
-            commaCount++;
-        }
+    assert(lastPiece == WHITE || lastPiece == BLACK);
+
+    // Walk in the same order as check_five_in_line_side() so that the recorded
+    // connection line is identical: rows, columns, diagonals, anti-diagonals.
+    // (A double five keeps the last one found, as the full scan does.)
+    const int       LINE_DIR[4]  = {0, 2, 3, 1};
+    const Direction LINE_STEP[4] = {DIRECTION[0],
+                                    DIRECTION[2],
+                                    DIRECTION[3],
+                                    (Direction)-DIRECTION[1]};
+
+    int fiveCnt = 0;
+    for (int l = 0; l < 4; l++) {
+        const int iDir = LINE_DIR[l];
+        const int len  = run_length(bitBoard.line(lastPiece, lastPos, iDir),
+                                   BitBoard::bit_index(lastPos, iDir));
+        if (AllowLong ? len < 5 : len != 5)
+            continue;
+
+        // The board is surrounded by walls, so both walks stop inside the array
+        const Direction step = LINE_STEP[l];
+        Pos start = lastPos;
+        while (board[start - step] == lastPiece)
+            start -= step;
+
+        int conCnt = 0;
+        Pos connectionLine[32];
+        for (Pos p = start; board[p] == lastPiece; p += step)
+            connectionLine[conCnt++] = p;
+
+        check_five_helper(AllowLong, conCnt, fiveCnt, connectionLine);
     }
 
-    assert(commaCount == 1);
-
-    size_t      secondLen = movestr.length() - commaIdx - 1;
-    std::string xstr {movestr.substr(0, commaIdx)};
-    std::string ystr {movestr.substr(commaIdx + 1, secondLen)};
+    return fiveCnt > 0;
+}
 
-    int x = std::stoi(xstr);
-    int y = std::stoi(ystr);
-    assert(x >= 0 && x < boardSize);
-    assert(y >= 0 && y < boardSize);
+bool Position::check_five_in_line_side(Color side, bool allow_long_connection)
+{
+    return allow_long_connection ? checkFiveSide<0, true>(side)
+                                 : checkFiveSide<0, false>(side);
+}
 
-    return buildMove(x, y, playerToMove);
+bool Position::check_five_in_line_lastmove(bool allow_long_connection)
+{
+    return allow_long_connection ? checkFiveLastmove<true>() : checkFiveLastmove<false>();
 }
 
-static bool isNumber(std::string &str)
+// Whether a side wins with an overline: in renju only white does
+template <GameRule Rule> constexpr bool allowLongConnection(Color side)
 {
-    char *p;
-    strtol(str.c_str(), &p, 10);
-    return !*p;
+    return Rule == GOMOKU_FIVE_OR_MORE || (Rule == RENJU && side == WHITE);
 }
 
-bool Position::is_valid_move_gomostr(std::string_view movestr)
+template <int Size, GameRule Rule> struct RuleKernelImpl
 {
-    int    commaCount = 0;
-    size_t commaIdx   = 0;
-    for (size_t i = 0; i < movestr.length(); i++) {
-        if (movestr[i] == ',') {
-            commaIdx = i;
-            commaCount++;
-        }
+    static Color lastSide(const Position &pos)
+    {
+        return ColorFromMove(pos.historyMoves[pos.moveCount - 1]);
     }
 
-    if (commaCount != 1) {
-        return false;  // no comma, or more than one comma?
+    static bool five_lastmove(Position &pos)
+    {
+        if (Rule == RENJU && pos.moveCount && lastSide(pos) == WHITE)
+            return pos.checkFiveLastmove<allowLongConnection<Rule>(WHITE)>();
+        return pos.checkFiveLastmove<allowLongConnection<Rule>(BLACK)>();
     }
 
-    size_t      secondLen = movestr.length() - commaIdx - 1;
-    std::string xstr {movestr.substr(0, commaIdx)};
-    std::string ystr {movestr.substr(commaIdx + 1, secondLen)};
+    static bool five_full_scan(Position &pos)
+    {
+        if (!pos.moveCount)
+            return false;
+        const Color side = lastSide(pos);
+        return allowLongConnection<Rule>(side) ? pos.checkFiveSide<Size, true>(side)
+                                               : pos.checkFiveSide<Size, false>(side);
+    }
 
-    // any of two coords are not number
-    return isNumber(xstr) && isNumber(ystr);
-}
+    static ForbiddenType forbidden(const Position &pos, move_t move)
+    {
+        if constexpr (Rule == RENJU)
+            return pos.check_forbidden_move(move);
+        else
+            return FORBIDDEN_NONE;
+    }
 
-std::string Position::move_to_gomostr(move_t move) const
-{
-    int               x = CoordX(PosFromMove(move));
-    int               y = CoordY(PosFromMove(move));
-    std::stringstream ss("");
-    ss << x << "," << y;
-    return ss.str();
-}
+    static constexpr RuleKernel kernel = {five_lastmove, five_full_scan, forbidden};
+};
 
-std::string Position::move_to_opening_str(move_t move, OpeningType type) const
+template <int Size> static const RuleKernel &ruleKernel(GameRule rule)
 {
-    std::stringstream ss;
-    int               hboardSize = this->boardSize / 2;
-    Pos               p          = PosFromMove(move);
-
-    switch (type) {
-    case OPENING_OFFSET:
-        ss << (CoordX(p) - hboardSize) << "," << (CoordY(p) - hboardSize);
-        break;
-    case OPENING_POS: ss << char(CoordX(p) + 'a') << int(CoordY(p) + 1); break;
+    switch (rule) {
+    case GOMOKU_EXACT_FIVE: return RuleKernelImpl<Size, GOMOKU_EXACT_FIVE>::kernel;
+    case RENJU: return RuleKernelImpl<Size, RENJU>::kernel;
+    default: return RuleKernelImpl<Size, GOMOKU_FIVE_OR_MORE>::kernel;
     }
-
-    return ss.str();
 }
 
-// apply the openning str in the specific format
-bool Position::apply_opening(std::string_view opening_str, OpeningType type)
+const RuleKernel &RuleKernel::get(int boardSize, GameRule rule)
 {
-    std::vector<Pos> openning_pos;
-    bool             parsingOk = false;
-    switch (type) {
-    case OPENING_OFFSET:
-        parsingOk = parse_opening_offset_linestr(openning_pos, opening_str);
-        break;
-    case OPENING_POS:
-        parsingOk = parse_opening_pos_linestr(openning_pos, opening_str);
-        break;
-    }
-    if (!parsingOk) {
-        return false;
+    switch (boardSize) {
+    case 15: return ruleKernel<15>(rule);
+    case 19: return ruleKernel<19>(rule);
+    case 20: return ruleKernel<20>(rule);
+    default: return ruleKernel<0>(rule);
     }
-
-    initBoard(boardSize);  // set board to initial state
-    for (size_t i = 0; i < openning_pos.size(); i++) {
-        move_t mv = buildMovePos(openning_pos[i], this->get_turn());
-        move(mv);  // make opening move
-    }
-    return true;
 }
 
-bool Position::parse_opening_offset_linestr(std::vector<Pos> &opening_pos,
-                                            std::string_view  linestr)
+move_t Position::gomostr_to_move(std::string_view movestr) const
 {
-    opening_pos.clear();
-    int hboardSize = this->boardSize / 2;
+    int x, y;
+    if (!parse_gomostr(movestr, x, y) || !isInBoardXY(x, y))
+        return NONE_MOVE;
 
-    std::stringstream ss;
-    for (size_t i = 0; i < linestr.size(); i++) {
-        char ch = linestr[i];
-        if ((ch <= '9' && ch >= '0') || ch == '-') {
-            ss << ch;
-        }
-        else if (ch == ',' || ch == ' ') {
-            ss << ' ';
-        }
-        else {
-            printf("Can not apply openning, unknown coordinate '%c'.\n", ch);
-            return false;
-        }
-    }
+    return buildMove(x, y, playerToMove);
+}
 
-    int cnt  = 0;
-    int ofst = -9999;
-    int buff[3];
-    while (ss >> ofst) {
-        if (ofst != -9999) {
-            if (ofst >= -16 && ofst <= 15) {
-                buff[cnt++] = ofst;
-                if (cnt == 2) {
-                    int currx = buff[0] + hboardSize;
-                    int curry = buff[1] + hboardSize;
-                    if (!isInBoardXY(currx, curry)) {
-                        printf(
-                            "Can not apply openning, the current board is too small.\n");
-                        return false;
-                    }
+bool Position::is_valid_move_gomostr(std::string_view movestr)
+{
+    int x, y;
+    return bool(parse_gomostr(movestr, x, y));
+}
 
-                    Pos p = POS(currx, curry);
-                    opening_pos.push_back(p);
+size_t Position::move_to_gomostr(move_t move, char *buf, size_t size) const
+{
+    Pos         p = PosFromMove(move);
+    CodecResult r = write_gomostr(buf, size, CoordX(p), CoordY(p));
+    return r ? r.pos : 0;
+}
 
-                    cnt = 0;
-                }
-            }
-        }
-        ofst = -9999;
-    }
+std::string Position::move_to_gomostr(move_t move) const
+{
+    char buf[16];
+    move_to_gomostr(move, buf, sizeof(buf));
+    return buf;
+}
 
-    return true;  // ok
+size_t Position::move_to_opening_str(move_t      move,
+                                     OpeningType type,
+                                     char       *buf,
+                                     size_t      size) const
+{
+    CodecResult r = write_opening_move(buf, size, type, boardSize, PosFromMove(move));
+    return r ? r.pos : 0;
 }
 
-bool Position::parse_opening_pos_linestr(std::vector<Pos> &opening_pos,
-                                         std::string_view  linestr)
+std::string Position::move_to_opening_str(move_t move, OpeningType type) const
 {
-    opening_pos.clear();
+    char buf[16];
+    move_to_opening_str(move, type, buf, sizeof(buf));
+    return buf;
+}
 
-    std::stringstream ss;
-    for (size_t i = 0; i < linestr.size(); i++) {
-        char ch = linestr[i];
+// apply the openning str in the specific format
+bool Position::apply_opening(std::string_view opening_str, OpeningType type)
+{
+    Pos         moves[RealBoardSize * RealBoardSize];
+    int         count;
+    CodecResult r =
+        parse_opening(opening_str, type, boardSize, moves, RealBoardSize * RealBoardSize, count);
+
+    if (!r) {
+        if (r.status == CODEC_OUT_OF_BOARD)
+            printf("Can not apply openning, the current board is too small.\n");
+        else
+            printf("Can not apply openning, %s at '%.*s'.\n",
+                   codec_status_str(r.status),
+                   (int)(opening_str.size() - r.pos),
+                   opening_str.data() + r.pos);
+        return false;
+    }
 
-        if (ch >= 'a' && ch <= 'z') {
-            ss << ' ' << int(ch - 'a') << ' ';
-        }
-        else if (ch >= '0' && ch <= '9') {
-            ss << ch;
-        }
-        else {
-            printf("Can not apply openning, unknown coordinate '%c'.\n", ch);
+    bool taken[MaxBoardSizeSqr] = {};
+    for (int i = 0; i < count; i++) {
+        if (taken[moves[i]]) {
+            printf("Can not apply openning, stone played twice.\n");
             return false;
         }
+        taken[moves[i]] = true;
     }
 
-    int cnt = 0;
-    int buff[3];
-    int coord = -9999;
-    while (ss >> coord) {
-        if (coord != -9999) {
-            buff[cnt++] = coord;
-            if (cnt == 2) {
-                int currx = buff[0];
-                int curry = buff[1] - 1;
-                if (!isInBoardXY(currx, curry)) {
-                    printf("Can not apply openning, the current board is too small.\n");
-                    return false;
-                }
-
-                Pos p = POS(currx, curry);
-                opening_pos.push_back(p);
-                cnt = 0;
-            }
-        }
-        coord = -9999;
+    initBoard(boardSize);  // set board to initial state
+    for (int i = 0; i < count; i++) {
+        move_t mv = buildMovePos(moves[i], this->get_turn());
+        move(mv);  // make opening move
     }
-
-    return true;  // ok
+    return true;
 }
 
 // convert a position back to opening string (assuming current position is
 // a normal position, played by black and white alternately)
-std::string Position::to_opening_str(OpeningType type) const
+size_t Position::to_opening_str(OpeningType type, char *buf, size_t size) const
 {
-    std::stringstream ss;
-    int               hboardSize = this->boardSize / 2;
-
-    switch (type) {
-    case OPENING_OFFSET:
-        for (int i = 0; i < get_move_count(); i++) {
-            Pos p = PosFromMove(get_hist_moves()[i]);
-            if (i)
-                ss << ", ";
-            ss << (CoordX(p) - hboardSize) << "," << (CoordY(p) - hboardSize);
+    size_t n = 0;
+    for (int i = 0; i < get_move_count(); i++) {
+        if (type == OPENING_OFFSET && i) {
+            if (n + 3 > size)
+                return 0;
+            buf[n++] = ',';
+            buf[n++] = ' ';
         }
-        break;
-    case OPENING_POS:
-        for (int i = 0; i < get_move_count(); i++) {
-            Pos p = PosFromMove(get_hist_moves()[i]);
-            ss << char(CoordX(p) + 'a') << int(CoordY(p) + 1);
-        }
-        break;
+        CodecResult r =
+            write_opening_move(buf + n, size - n, type, boardSize, PosFromMove(historyMoves[i]));
+        if (!r)
+            return 0;
+        n += r.pos;
     }
 
-    return ss.str();
+    if (n >= size)
+        return 0;
+    buf[n] = '\0';
+    return n;
+}
+
+std::string Position::to_opening_str(OpeningType type) const
+{
+    // at most "-16,-16, " per move
+    char buf[RealBoardSize * RealBoardSize * 9 + 1];
+    to_opening_str(type, buf, sizeof(buf));
+    return buf;
 }
 
 // this is a static method
 void Position::move_with_copy(const Position &before, move_t m)
 {
-    memcpy(this, &before, sizeof(Position));
+    *this = before;
     move(m);
 }
 
 // renju helpers
-ForbiddenType Position::isForbidden(Pos pos)
+namespace {
+
+bool hasFive(const LinePattern patterns[4])
 {
-    if (isDoubleThree(pos, BLACK))
-        return DOUBLE_THREE;
-    else if (isDoubleFour(pos, BLACK))
-        return DOUBLE_FOUR;
-    else if (isOverline(pos, BLACK))
-        return OVERLINE;
-    else
-        return FORBIDDEN_NONE;
+    return patterns[0].five | patterns[1].five | patterns[2].five | patterns[3].five;
 }
 
-bool Position::isFive(Pos pos, Color piece)
+bool hasOverline(const LinePattern patterns[4])
 {
-    if (board[pos] != EMPTY)
-        return false;
-
-    for (int iDir = 0; iDir < 4; iDir++) {
-        if (isFive(pos, piece, iDir))
-            return true;
-    }
-    return false;
+    return patterns[0].overline | patterns[1].overline | patterns[2].overline
+           | patterns[3].overline;
 }
 
-bool Position::isFive(Pos pos, Color piece, int iDir)
+// Fours only count when the stone makes neither a five nor, for black, an overline
+bool isDoubleFour(const LinePattern patterns[4], Color piece)
 {
-    if (board[pos] != EMPTY)
+    if (hasFive(patterns) || (piece == BLACK && hasOverline(patterns)))
         return false;
-
-    int i, j;
-    int count = 1;
-    for (i = 1; i < 6; i++) {
-        if (board[pos - DIRECTION[iDir] * i] == piece)
-            count++;
-        else
-            break;
-    }
-    for (j = 1; j < 7 - i; j++) {
-        if (board[pos + DIRECTION[iDir] * j] == piece)
-            count++;
-        else
-            break;
-    }
-    return count == 5;
+    return patterns[0].fours + patterns[1].fours + patterns[2].fours + patterns[3].fours
+           >= 2;
 }
 
-bool Position::isOverline(Pos pos, Color piece)
-{
-    if (board[pos] != EMPTY)
-        return false;
+}  // namespace
 
-    for (Direction dir : DIRECTION) {
-        int i, j;
-        int count = 1;
-        for (i = 1; i < 6; i++) {
-            if (board[pos - dir * i] == piece)
-                count++;
-            else
-                break;
-        }
-        for (j = 1; j < 7 - i; j++) {
-            if (board[pos + dir * j] == piece)
-                count++;
-            else
-                break;
-        }
-        if (count > 5)
-            return true;
-    }
-    return false;
+ForbiddenType Position::isForbidden(Pos                 pos,
+                                    const CellPatterns  patterns,
+                                    const CellPatterns *cache) const
+{
+    if (isDoubleThree(pos, BLACK, patterns, nullptr, cache))
+        return DOUBLE_THREE;
+    else if (isDoubleFour(patterns, BLACK))
+        return DOUBLE_FOUR;
+    else if (hasOverline(patterns))
+        return OVERLINE;
+    else
+        return FORBIDDEN_NONE;
 }
 
-bool Position::isFour(Pos pos, Color piece, int iDir)
+void Position::forbidden_map(ForbiddenType map[MaxBoardSizeSqr]) const
 {
-    if (board[pos] != EMPTY)
-        return false;
-    else if (isFive(pos, piece))
-        return false;
-    else if (piece == BLACK && isOverline(pos, BLACK))
-        return false;
-    else if (piece == BLACK || piece == WHITE) {
-        bool four = false;
-        setPiece(pos, piece);
-
-        int i, j;
-        for (i = 1; i < 5; i++) {
-            Pos posi = pos - DIRECTION[iDir] * i;
-            if (board[posi] == piece)
-                continue;
-            else if (board[posi] == EMPTY && isFive(posi, piece, iDir))
-                four = true;
-            break;
-        }
-        for (j = 1; !four && j < 6 - i; j++) {
-            Pos posi = pos + DIRECTION[iDir] * j;
-            if (board[posi] == piece)
-                continue;
-            else if (board[posi] == EMPTY && isFive(posi, piece, iDir))
-                four = true;
-            break;
+    const PatternTable &table      = PatternTable::get();
+    const uint32_t     *boardLines = BitBoard::board_lines(boardSize);
+
+    // Look every empty cell up in one pass over the line words, so that the searches
+    // below only redo the lines that go through the stones they try
+    CellPatterns cache[MaxBoardSizeSqr];
+    for (int iDir = 0; iDir < 4; iDir++)
+        for (int li = BitBoard::FirstLine[iDir]; li < BitBoard::FirstLine[iDir + 1]; li++) {
+            const uint32_t own   = bitBoard.line(BLACK, li);
+            const uint32_t empty = boardLines[li] & ~own & ~bitBoard.line(WHITE, li);
+            for (uint32_t b = empty; b; b &= b - 1) {
+                const int k                          = __builtin_ctz(b);
+                cache[BitBoard::pos_at(li, k)][iDir] = table[table.key(own, empty, k)];
+            }
         }
 
-        delPiece(pos);
-        return four;
+    for (int pos = 0; pos < MaxBoardSizeSqr; pos++) {
+        map[pos] = FORBIDDEN_NONE;
+        if (board[pos] != EMPTY)
+            continue;
+
+        // Most cells have no line that could take part in a forbidden shape
+        const CellPatterns &patterns = cache[pos];
+        bool                relevant = false;
+        for (int iDir = 0; iDir < 4; iDir++)
+            relevant |= patterns[iDir].overline || patterns[iDir].fours
+                        || patterns[iDir].threeLow || patterns[iDir].threeHigh;
+        if (relevant)
+            map[pos] = isForbidden(pos, patterns, cache);
     }
-    else
-        return false;
 }
 
-Position::OpenFourType Position::isOpenFour(Pos pos, Color piece, int iDir)
+void Position::threat_features(GameRule rule, ThreatFeatures &features) const
 {
-    if (board[pos] != EMPTY)
-        return OF_NONE;
-    else if (isFive(pos, piece))
-        return OF_NONE;
-    else if (piece == BLACK && isOverline(pos, BLACK))
-        return OF_NONE;
-    else if (piece == BLACK || piece == WHITE) {
-        setPiece(pos, piece);
+    const PatternTable &table      = PatternTable::get();
+    const uint32_t     *boardLines = BitBoard::board_lines(boardSize);
+
+    memset(&features, 0, sizeof(features));
+
+    for (int c = BLACK; c <= WHITE; c++) {
+        const Color color     = Color(c);
+        const bool  allowLong = rule == GOMOKU_FIVE_OR_MORE || (rule == RENJU && c == WHITE);
+        uint64_t(&cells)[NB_THREAT][ThreatFeatures::Words] = features.cells[c];
+        uint64_t anyFour[ThreatFeatures::Words]            = {};
+        uint64_t anyThree[ThreatFeatures::Words]           = {};
+
+        for (int iDir = 0; iDir < 4; iDir++)
+            for (int li = BitBoard::FirstLine[iDir]; li < BitBoard::FirstLine[iDir + 1];
+                 li++) {
+                // a three needs two stones already on the line
+                const uint32_t own = bitBoard.line(color, li);
+                if (__builtin_popcount(own) < 2)
+                    continue;
+
+                const uint32_t empty =
+                    boardLines[li] & ~own & ~bitBoard.line(opponent_color(color), li);
+                for (uint32_t b = empty; b; b &= b - 1) {
+                    const int k = __builtin_ctz(b);
+                    if (__builtin_popcount(own & (0x1FFu << (k - 4))) < 2)
+                        continue;
+
+                    const LinePattern &lp  = table[table.key(own, empty, k)];
+                    const Pos          pos = BitBoard::pos_at(li, k);
+                    const int          w   = pos >> 6;
+                    const uint64_t     bit = 1ULL << (pos & 63);
+
+                    if (lp.five || (lp.overline && allowLong))
+                        cells[THREAT_FIVE][w] |= bit;
+                    else if (allowLong ? lp.longFours : lp.fours) {
+                        const bool open = allowLong ? lp.longFours == 2
+                                                    : lp.openFour || lp.fours == 2;
+                        cells[open ? THREAT_OPEN_FOUR : THREAT_FOUR][w] |= bit;
+                        cells[THREAT_DOUBLE_FOUR][w] |= anyFour[w] & bit;
+                        anyFour[w] |= bit;
+                    }
+                    else if (lp.threeLow || lp.threeHigh) {
+                        cells[THREAT_THREE][w] |= bit;
+                        cells[THREAT_DOUBLE_THREE][w] |= anyThree[w] & bit;
+                        anyThree[w] |= bit;
+                    }
+                }
+            }
 
-        int i, j;
-        int count = 1;
-        int five  = 0;
+        for (int w = 0; w < ThreatFeatures::Words; w++)
+            cells[THREAT_FOUR_THREE][w] = anyFour[w] & anyThree[w];
+    }
 
-        for (i = 1; i < 5; i++) {
-            Pos posi = pos - DIRECTION[iDir] * i;
-            if (board[posi] == piece) {
-                count++;
-                continue;
+    // Black can not play its forbidden cells under renju
+    if (rule == RENJU)
+        for (int w = 0; w < ThreatFeatures::Words; w++) {
+            uint64_t any = 0;
+            for (int t = 0; t < NB_THREAT; t++)
+                any |= features.cells[BLACK][t][w];
+
+            for (; any; any &= any - 1) {
+                const int i = __builtin_ctzll(any);
+                if (check_forbidden_move(buildMovePos(Pos(w * 64 + i), BLACK)))
+                    for (int t = 0; t < NB_THREAT; t++)
+                        features.cells[BLACK][t][w] &= ~(1ULL << i);
             }
-            else if (board[posi] == EMPTY)
-                five += isFive(posi, piece, iDir);
-            break;
-        }
-        for (j = 1; five && j < 6 - i; j++) {
-            Pos posi = pos + DIRECTION[iDir] * j;
-            if (board[posi] == piece) {
-                count++;
-                continue;
-            }
-            else if (board[posi] == EMPTY)
-                five += isFive(posi, piece, iDir);
-            break;
         }
 
-        delPiece(pos);
-        return five == 2 ? (count == 4 ? OF_TRUE : OF_LONG) : OF_NONE;
-    }
-    else
-        return OF_NONE;
+    for (int c = BLACK; c <= WHITE; c++)
+        for (int t = 0; t < NB_THREAT; t++)
+            for (int w = 0; w < ThreatFeatures::Words; w++)
+                features.count[c][t] += __builtin_popcountll(features.cells[c][t][w]);
 }
 
-bool Position::isOpenThree(Pos pos, Color piece, int iDir)
+void Position::threat_features(const Position *const positions[],
+                               size_t                count,
+                               GameRule              rule,
+                               ThreatFeatures        features[])
 {
-    if (board[pos] != EMPTY)
-        return false;
-    else if (isFive(pos, piece))
-        return false;
-    else if (piece == BLACK && isOverline(pos, BLACK))
-        return false;
-    else if (piece == BLACK || piece == WHITE) {
-        bool openthree = false;
-        setPiece(pos, piece);
-
-        int i, j;
-        for (i = 1; i < 5; i++) {
-            Pos posi = pos - DIRECTION[iDir] * i;
-            if (board[posi] == piece)
-                continue;
-            else if (board[posi] == EMPTY && isOpenFour(posi, piece, iDir) == OF_TRUE
-                     && !isDoubleFour(posi, piece) && !isDoubleThree(posi, piece))
-                openthree = true;
-            break;
-        }
-        for (j = 1; !openthree && j < 6 - i; j++) {
-            Pos posi = pos + DIRECTION[iDir] * j;
-            if (board[posi] == piece)
-                continue;
-            else if (board[posi] == EMPTY && isOpenFour(posi, piece, iDir) == OF_TRUE
-                     && !isDoubleFour(posi, piece) && !isDoubleThree(posi, piece))
-                openthree = true;
-            break;
-        }
-
-        delPiece(pos);
-        return openthree;
-    }
-    else
-        return false;
+    for (size_t i = 0; i < count; i++)
+        positions[i]->threat_features(rule, features[i]);
 }
 
-bool Position::isDoubleFour(Pos pos, Color piece)
+// Looks up the line through the empty cell pos, for a stone of piece put on it
+LinePattern Position::linePattern(Pos                 pos,
+                                  Color               piece,
+                                  int                 iDir,
+                                  const VirtualStone *virtualStones) const
 {
-    if (board[pos] != EMPTY)
-        return false;
-    else if (isFive(pos, piece))
-        return false;
+    const PatternTable &table = PatternTable::get();
+    const int           li    = BitBoard::line_index(pos, iDir);
 
-    int nFour = 0;
-    for (int iDir = 0; iDir < 4; iDir++) {
-        if (isOpenFour(pos, piece, iDir) == OF_LONG)
-            nFour += 2;
-        else if (isFour(pos, piece, iDir))
-            nFour++;
+    uint32_t own = bitBoard.line(piece, pos, iDir);
+    for (const VirtualStone *vs = virtualStones; vs; vs = vs->next)
+        if (BitBoard::line_index(vs->pos, iDir) == li)
+            own |= 1u << BitBoard::bit_index(vs->pos, iDir);
 
-        if (nFour >= 2)
-            return true;
+    const uint32_t empty = BitBoard::board_lines(boardSize)[li] & ~own
+                           & ~bitBoard.line(opponent_color(piece), pos, iDir);
+    return table[table.key(own, empty, BitBoard::bit_index(pos, iDir))];
+}
+
+// Looks up the four lines through the empty cell pos. With a cache (bare board, black),
+// only the lines that have a virtual stone close enough to matter are looked up again.
+void Position::linePatterns(Pos                 pos,
+                            Color               piece,
+                            const VirtualStone *virtualStones,
+                            const CellPatterns *cache,
+                            CellPatterns        patterns) const
+{
+    assert(board[pos] == EMPTY);
+    assert(!cache || piece == BLACK);
+
+    int dirty = 0xF;
+    if (cache) {
+        memcpy(patterns, cache[pos], sizeof(CellPatterns));
+        dirty = 0;
+        for (const VirtualStone *vs = virtualStones; vs; vs = vs->next)
+            for (int iDir = 0; iDir < 4; iDir++)
+                if (BitBoard::line_index(vs->pos, iDir) == BitBoard::line_index(pos, iDir)
+                    && std::abs(BitBoard::bit_index(vs->pos, iDir)
+                                - BitBoard::bit_index(pos, iDir))
+                           <= 5)
+                    dirty |= 1 << iDir;
     }
 
-    return false;
+    for (int iDir = 0; iDir < 4; iDir++)
+        if (dirty & (1 << iDir))
+            patterns[iDir] = linePattern(pos, piece, iDir, virtualStones);
 }
 
-bool Position::isDoubleThree(Pos pos, Color piece)
+// Checks that the empty cell pos, which makes a straight four on one line, is really
+// an open four spot: no five or overline, and not forbidden itself
+bool Position::isOpenFourEnd(Pos                 pos,
+                             Color               piece,
+                             const VirtualStone *virtualStones,
+                             const CellPatterns *cache) const
 {
-    if (board[pos] != EMPTY)
+    CellPatterns patterns;
+    linePatterns(pos, piece, virtualStones, cache, patterns);
+
+    if (hasFive(patterns) || (piece == BLACK && hasOverline(patterns)))
         return false;
-    else if (isFive(pos, piece))
+    return !isDoubleFour(patterns, piece)
+           && !isDoubleThree(pos, piece, patterns, virtualStones, cache);
+}
+
+// Renju's recursive three: a line is an open three if, with the stone put on pos,
+// one of its straight four spots can be played
+bool Position::isDoubleThree(Pos                 pos,
+                             Color               piece,
+                             const CellPatterns  patterns,
+                             const VirtualStone *virtualStones,
+                             const CellPatterns *cache) const
+{
+    if (hasFive(patterns) || (piece == BLACK && hasOverline(patterns)))
         return false;
 
+    // Cheap bound before any recursion: at least two lines must look like threes
+    int nCandidate = 0;
+    for (int iDir = 0; iDir < 4; iDir++)
+        nCandidate += patterns[iDir].threeLow || patterns[iDir].threeHigh;
+    if (nCandidate < 2)
+        return false;
+
+    const VirtualStone withStone = {pos, virtualStones};
+
     int nThree = 0;
     for (int iDir = 0; iDir < 4; iDir++) {
-        if (isOpenThree(pos, piece, iDir))
+        const LinePattern &p = patterns[iDir];
+        if ((p.threeLow
+             && isOpenFourEnd(pos - DIRECTION[iDir] * p.threeLow, piece, &withStone, cache))
+            || (p.threeHigh
+                && isOpenFourEnd(pos + DIRECTION[iDir] * p.threeHigh,
+                                 piece,
+                                 &withStone,
+                                 cache)))
             nThree++;
 
         if (nThree >= 2)
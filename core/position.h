@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include "bitboard.h"
+#include "pattern.h"
+
 #include <cassert>
 #include <string>
 #include <string_view>
@@ -27,7 +30,7 @@ typedef uint16_t Pos;
 
 const move_t NONE_MOVE = 0xFFFF;
 
-enum Color { BLACK, WHITE, EMPTY, WALL };
+enum Color : uint8_t { BLACK, WHITE, EMPTY, WALL };
 
 #define BOARD_BOUNDARY     5
 #define MAX_BOARD_SIZE_BIT 5
@@ -54,6 +57,20 @@ enum TransformType {
     NB_TRANS
 };
 
+// Patterns a stone of one colour makes on an empty cell (see ThreatFeatures)
+enum ThreatType {
+    THREAT_FIVE,          // a winning five under the rule
+    THREAT_OPEN_FOUR,     // a line with two five spots (straight four, or O_OOO_O)
+    THREAT_FOUR,          // a line with one five spot
+    THREAT_DOUBLE_FOUR,   // fours on two lines
+    THREAT_FOUR_THREE,    // a four on one line and a three on another
+    THREAT_THREE,         // a line that can turn into a straight four
+    THREAT_DOUBLE_THREE,  // threes on two lines
+    NB_THREAT
+};
+
+struct ThreatFeatures;
+
 class Position
 {
 public:
@@ -62,73 +79,164 @@ public:
     static const int RealBoardSize   = MaxBoardSize - 2 * BOARD_BOUNDARY;
 
     Position(int bSize = 15);
+    Position(const Position &other);
+    Position &operator=(const Position &other);
 
     inline int           get_size() const { return boardSize; }
     inline Color         get_turn() const { return playerToMove; }
     inline int           get_move_count() const { return moveCount; }
     inline int           get_moves_left() const { return boardSizeSqr - moveCount; }
     inline const move_t *get_hist_moves() const { return historyMoves; }
+    inline uint64_t      get_key() const { return zobristKey; }
+    // five windows (five cells in a row on the board) free of stones of the opponent
+    inline int           get_open_windows(Color c) const { return openWindows[c]; }
+    // no five can be made any more, by either side
+    inline bool          is_dead() const { return !(openWindows[BLACK] | openWindows[WHITE]); }
+    // cells of the five recorded by the last five check that found one
+    inline int           get_win_connection_len() const { return winConnectionLen; }
+    inline const Pos    *get_win_connection() const { return winConnectionPos; }
 
     void move(move_t m);
     void undo();
     void transform(TransformType type);
     void move_with_copy(const Position &before, move_t m);
 
+    // applies the symmetry giving the smallest zobrist key, and returns it
+    TransformType canonicalize();
+    // that smallest key, the same for all symmetric variants of the position
+    uint64_t get_canonical_key() const;
+
+    // NONE_MOVE if movestr is not a valid move on this board
     move_t      gomostr_to_move(std::string_view movestr) const;
     std::string move_to_gomostr(move_t move) const;
     std::string move_to_opening_str(move_t move, OpeningType type) const;
+    // same into a caller buffer: returns the length written (NUL excluded), or 0 if
+    // the buffer is too small
+    size_t move_to_gomostr(move_t move, char *buf, size_t size) const;
+    size_t move_to_opening_str(move_t move, OpeningType type, char *buf, size_t size) const;
 
     void print() const;
 
     bool          is_legal_move(move_t move) const;
     ForbiddenType check_forbidden_move(move_t move) const;
+    // forbidden type for black of every cell, indexed by Pos (FORBIDDEN_NONE for
+    // stones and out of the board); reentrant, like check_forbidden_move()
+    void forbidden_map(ForbiddenType map[MaxBoardSizeSqr]) const;
 
+    // threat patterns of both colours (reentrant too); cells forbidden for black are
+    // left out under renju. The batch version fills features[i] for positions[i].
+    void        threat_features(GameRule rule, ThreatFeatures &features) const;
+    static void threat_features(const Position *const positions[],
+                                size_t                count,
+                                GameRule              rule,
+                                ThreatFeatures        features[]);
+
+    // full board scan for a five of the given side
     bool check_five_in_line_side(Color side,
                                  bool  allow_long_connection = true);  // const;
-    bool check_five_in_line_lastmove(bool allow_long_connection);     // const;
+    // only scans the four lines through the last move
+    bool check_five_in_line_lastmove(bool allow_long_connection);  // const;
 
     // about opening
     bool        apply_opening(std::string_view opening_str, OpeningType type);
     std::string to_opening_str(OpeningType type) const;
+    size_t      to_opening_str(OpeningType type, char *buf, size_t size) const;
 
     static bool is_valid_move_gomostr(std::string_view movestr);
 
 private:
-    Color  board[MaxBoardSizeSqr];
-    int    boardSize;
-    int    boardSizeSqr;
-    int    moveCount;
-    move_t historyMoves[MaxBoardSizeSqr];
-    Color  playerToMove;
-    int    winConnectionLen;
-    Pos    winConnectionPos[32];
+    // Hot scalar fields are packed at the front. The move history must stay the
+    // last member: copies only transfer its first moveCount entries.
+    int16_t  boardSize;
+    int16_t  boardSizeSqr;
+    int16_t  moveCount;
+    Color    playerToMove;
+    uint8_t  winConnectionLen;
+    uint64_t zobristKey;  // stones of both colours, board size and side to move
+    int16_t  openWindows[NB_COLOR];  // kept up to date by setPiece()/delPiece()
+    Pos      winConnectionPos[RealBoardSize];
+    Color    board[MaxBoardSizeSqr];
+    BitBoard bitBoard;  // per-colour line planes mirroring board[] for line scans
+    move_t   historyMoves[RealBoardSize * RealBoardSize];
 
     void initBoard(int size);
+    void resetOpenWindows();
     void setPiece(Pos pos, Color piece);
     void delPiece(Pos pos);
     bool isInBoard(Pos pos) const;
     bool isInBoardXY(int x, int y) const;
 
+    TransformType bestTransform(uint64_t &bestKey) const;
+
+    template <int Size, bool AllowLong> bool checkFiveSide(Color side);
+    template <bool AllowLong> bool           checkFiveLastmove();
+    template <int Size, GameRule Rule> friend struct RuleKernelImpl;
+    friend class VcfSolver;
+
     void check_five_helper(bool allow_long_connc,
                            int &conCnt,
                            int &fiveCnt,
                            Pos *connectionLine);
-    bool parse_opening_offset_linestr(std::vector<Pos> &opening_pos,
-                                      std::string_view  linestr);
-    bool parse_opening_pos_linestr(std::vector<Pos> &opening_pos,
-                                   std::string_view  linestr);
-
-    // renju helpers
-    enum OpenFourType { OF_NONE, OF_TRUE /*_OOOO_*/, OF_LONG /*O_OOO_O*/ };
-    ForbiddenType isForbidden(Pos pos);
-    bool          isFive(Pos pos, Color piece);
-    bool          isFive(Pos pos, Color piece, int iDir);
-    bool          isOverline(Pos pos, Color piece);
-    bool          isFour(Pos pos, Color piece, int iDir);
-    OpenFourType  isOpenFour(Pos pos, Color piece, int iDir);
-    bool          isOpenThree(Pos pos, Color piece, int iDir);
-    bool          isDoubleFour(Pos pos, Color piece);
-    bool          isDoubleThree(Pos pos, Color piece);
+
+    // renju helpers: stones tried by the recursive three check are kept in a list of
+    // virtual stones instead of being put on the board, so that they can stay const.
+    // A whole map search also passes the bare board patterns of every cell (cache).
+    struct VirtualStone
+    {
+        Pos                 pos;
+        const VirtualStone *next;
+    };
+    typedef LinePattern CellPatterns[4];
+
+    ForbiddenType isForbidden(Pos                 pos,
+                              const CellPatterns  patterns,
+                              const CellPatterns *cache) const;
+    LinePattern
+         linePattern(Pos pos, Color piece, int iDir, const VirtualStone *virtualStones) const;
+    void linePatterns(Pos                 pos,
+                      Color               piece,
+                      const VirtualStone *virtualStones,
+                      const CellPatterns *cache,
+                      CellPatterns        patterns) const;
+    bool isOpenFourEnd(Pos                 pos,
+                       Color               piece,
+                       const VirtualStone *virtualStones,
+                       const CellPatterns *cache) const;
+    bool isDoubleThree(Pos                 pos,
+                       Color               piece,
+                       const CellPatterns  patterns,
+                       const VirtualStone *virtualStones,
+                       const CellPatterns *cache) const;
+};
+
+// Rule checks with the rule, and the board size for the common sizes (15, 19, 20), known
+// at compile time. Other sizes use a generic kernel. Board size and rule are fixed for a
+// whole tournament, so the kernel is picked once from the options.
+struct RuleKernel
+{
+    // the last move made a winning line (the connection line is recorded)
+    bool (*five_lastmove)(Position &pos);
+    // same, but found by scanning the whole board (for regression checks)
+    bool (*five_full_scan)(Position &pos);
+    // forbidden type of a move (always FORBIDDEN_NONE unless the rule is renju)
+    ForbiddenType (*forbidden)(const Position &pos, move_t move);
+
+    static const RuleKernel &get(int boardSize, GameRule rule);
+};
+
+// Locations (one bit per Pos) and counts of the empty cells where a stone of each
+// colour makes each threat pattern. A cell can have several patterns.
+struct ThreatFeatures
+{
+    static const int Words = Position::MaxBoardSizeSqr / 64;
+
+    uint16_t count[NB_COLOR][NB_THREAT];
+    uint64_t cells[NB_COLOR][NB_THREAT][Words];
+
+    bool has(Color color, ThreatType type, Pos pos) const
+    {
+        return cells[color][type][pos >> 6] >> (pos & 63) & 1;
+    }
 };
 
 inline Color oppositeColor(Color color)
@@ -0,0 +1,190 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __linux__
+
+    #include "reactor.h"
+
+    #include "util.h"
+
+    #include <sys/epoll.h>
+    #include <sys/mman.h>
+    #include <ucontext.h>
+    #include <unistd.h>
+
+    #include <algorithm>
+    #include <cassert>
+    #include <cerrno>
+    #include <climits>
+
+// The default thread stack size: tasks run the code that worker threads used to run.
+// Pages are only committed when used.
+static const size_t TaskStackSize = 8 << 20;
+
+struct Reactor::Task
+{
+    std::function<void()> fn;  // cleared when the task has returned
+    ucontext_t            ctx;
+    char                 *stack     = nullptr;
+    int                   fd        = -1;  // waited for
+    int64_t               timeLimit = 0;   // of the wait (0 for none)
+    bool                  woken     = false;
+};
+
+static thread_local Reactor *threadReactor = nullptr;
+
+Reactor::Reactor() : loop(new Task), running(nullptr)
+{
+    DIE_IF(0, (epfd = epoll_create1(EPOLL_CLOEXEC)) < 0);
+}
+
+Reactor::~Reactor()
+{
+    for (Task *task : tasks)
+        delete task;
+    delete loop;
+    DIE_IF(0, close(epfd) < 0);
+}
+
+void Reactor::spawn(std::function<void()> fn)
+{
+    Task *task = new Task;
+    task->fn   = std::move(fn);
+    tasks.push_back(task);
+}
+
+Reactor *Reactor::current()
+{
+    return threadReactor && threadReactor->running ? threadReactor : nullptr;
+}
+
+void Reactor::task_entry()
+{
+    Task *task = threadReactor->running;
+    task->fn();
+    task->fn = nullptr;
+    // returns to run() through uc_link
+}
+
+void Reactor::resume(Task *task)
+{
+    running = task;
+    DIE_IF(0, swapcontext(&loop->ctx, &task->ctx) < 0);
+    running = nullptr;
+
+    if (!task->fn) {
+        DIE_IF(0, munmap(task->stack, TaskStackSize) < 0);
+        task->stack = nullptr;
+    }
+}
+
+void Reactor::run()
+{
+    assert(!threadReactor);
+    threadReactor = this;
+
+    for (Task *task : tasks) {
+        // Stack with a guard page at the bottom, to crash on overflow
+        void *mem = mmap(nullptr,
+                         TaskStackSize,
+                         PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                         -1,
+                         0);
+        DIE_IF(0, mem == MAP_FAILED);
+        DIE_IF(0, mprotect(mem, getpagesize(), PROT_NONE) < 0);
+        task->stack = (char *)mem;
+
+        DIE_IF(0, getcontext(&task->ctx) < 0);
+        task->ctx.uc_stack.ss_sp   = mem;
+        task->ctx.uc_stack.ss_size = TaskStackSize;
+        task->ctx.uc_link          = &loop->ctx;
+        makecontext(&task->ctx, task_entry, 0);
+        ready.push_back(task);
+    }
+
+    size_t                   alive = tasks.size();
+    std::vector<epoll_event> events(std::max<size_t>(tasks.size(), 1));
+
+    while (true) {
+        // Run the ready tasks, until each one waits or returns
+        for (Task *task : ready) {
+            resume(task);
+            alive -= !task->fn;
+        }
+        ready.clear();
+
+        if (!alive)
+            break;
+
+        // Sleep until a pipe is readable, or the earliest time limit passes
+        int64_t timeLimit = 0;
+        for (Task *task : waiting)
+            if (task->timeLimit && (!timeLimit || task->timeLimit < timeLimit))
+                timeLimit = task->timeLimit;
+
+        int timeout = -1;
+        if (timeLimit)
+            timeout = (int)std::min<int64_t>(
+                std::max<int64_t>(timeLimit - system_msec(), 0),
+                INT_MAX);
+
+        const int n = epoll_wait(epfd, events.data(), (int)events.size(), timeout);
+        DIE_IF(0, n < 0 && errno != EINTR);
+
+        for (int i = 0; i < n; i++)
+            ((Task *)events[i].data.ptr)->woken = true;
+
+        const int64_t now = system_msec();
+        for (size_t i = 0; i < waiting.size();) {
+            Task *task = waiting[i];
+
+            if (task->woken || (task->timeLimit && now >= task->timeLimit)) {
+                DIE_IF(0, epoll_ctl(epfd, EPOLL_CTL_DEL, task->fd, nullptr) < 0);
+                ready.push_back(task);
+                waiting[i] = waiting.back();
+                waiting.pop_back();
+            }
+            else
+                i++;
+        }
+    }
+
+    threadReactor = nullptr;
+}
+
+int Reactor::wait_readable(int fd, int64_t timeLimit)
+{
+    Task *task = running;
+    assert(task);
+
+    epoll_event ev = {};
+    ev.events      = EPOLLIN;
+    ev.data.ptr    = task;
+    DIE_IF(0, epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0);
+
+    task->fd        = fd;
+    task->timeLimit = timeLimit;
+    task->woken     = false;
+    waiting.push_back(task);
+
+    // Back to run(), which resumes this task when it is woken or timed out
+    DIE_IF(0, swapcontext(&task->ctx, &loop->ctx) < 0);
+
+    return task->woken;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Cooperative scheduler for the game loops (Linux only). Each task runs on its own stack,
+// so that the game and engine code stays sequential: when a task would block on an
+// engine pipe, it yields instead, and the reactor waits for the pipes and time limits of
+// all its tasks in a single epoll_wait(). A reactor and its tasks live in one thread.
+class Reactor
+{
+public:
+    Reactor();
+    Reactor(const Reactor &) = delete;  // disable copy
+    ~Reactor();
+
+    // Adds a task, started by run()
+    void spawn(std::function<void()> fn);
+
+    // Runs the tasks until they have all returned
+    void run();
+
+    // Reactor of the task running in this thread (nullptr outside of a task)
+    static Reactor *current();
+
+    // From a task: waits until fd is readable (returns 1) or until timeLimit passes
+    // (system_msec() time, 0 for none, returns 0), running the other tasks meanwhile
+    int wait_readable(int fd, int64_t timeLimit);
+
+private:
+    struct Task;
+
+    static void task_entry();
+    void        resume(Task *task);
+
+    int                 epfd;
+    Task               *loop;     // context of run(), which the tasks yield to
+    Task               *running;  // task being run (nullptr in the loop)
+    std::vector<Task *> tasks, ready, waiting;
+};
@@ -0,0 +1,77 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "solvedcache.h"
+
+#include "util.h"
+
+#include <cassert>
+
+SolvedCache::SolvedCache(size_t sizeMB) : hits(0), misses(0), stores(0)
+{
+    // largest power of two number of entries that fits (at least one)
+    size_t count = 1;
+    while (count * 2 * sizeof(uint64_t) <= (sizeMB << 20))
+        count *= 2;
+
+    table = new std::atomic<uint64_t>[count];
+    mask  = count - 1;
+    for (size_t i = 0; i < count; i++)
+        table[i].store(0, std::memory_order_relaxed);
+}
+
+SolvedCache::~SolvedCache()
+{
+    delete[] table;
+}
+
+uint64_t SolvedCache::key(const Position &pos, GameRule rule)
+{
+    return pos.get_canonical_key() ^ ((uint64_t)(rule + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+bool SolvedCache::probe(uint64_t key, int &result)
+{
+    const uint64_t entry = table[(key >> 2) & mask].load(std::memory_order_relaxed);
+
+    if (entry && (entry & ~3ULL) == (key & ~3ULL)) {
+        result = int(entry & 3) - 1;
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void SolvedCache::store(uint64_t key, int result)
+{
+    assert(0 <= result && result <= 2);
+    table[(key >> 2) & mask].store((key & ~3ULL) | uint64_t(result + 1),
+                                   std::memory_order_relaxed);
+    stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string SolvedCache::stats() const
+{
+    const uint64_t h = get_hits(), m = get_misses();
+    return format("Solved cache: %" PRIu64 " hits, %" PRIu64 " misses (%.1f%%), %" PRIu64
+                  " stored\n",
+                  h,
+                  m,
+                  h + m ? 100.0 * h / (h + m) : 0.0,
+                  stores.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,52 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "position.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Tournament-wide cache of solved positions, shared by all workers (thread safe, lock
+// free). Positions are keyed by their canonical zobrist key, which covers the stones,
+// the board size and the side to move, mixed with the rule. Each entry holds the
+// result from the side to move's pov (RESULT_LOSS/DRAW/WIN, see game.h). The table has
+// a fixed size, and a new entry simply replaces the one in its slot.
+class SolvedCache
+{
+public:
+    explicit SolvedCache(size_t sizeMB);
+    ~SolvedCache();
+
+    static uint64_t key(const Position &pos, GameRule rule);
+
+    // true (and the result) if the position is known; counts hits and misses
+    bool probe(uint64_t key, int &result);
+    void store(uint64_t key, int result);
+
+    uint64_t    get_hits() const { return hits.load(std::memory_order_relaxed); }
+    uint64_t    get_misses() const { return misses.load(std::memory_order_relaxed); }
+    std::string stats() const;
+
+private:
+    // an entry is the key with its two low bits replaced by result + 1 (0 = empty)
+    std::atomic<uint64_t> *table;
+    size_t                 mask;
+    std::atomic<uint64_t>  hits, misses, stores;
+};
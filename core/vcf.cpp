@@ -0,0 +1,264 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vcf.h"
+
+#include "util.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+int plane_of(int li)
+{
+    return li < BitBoard::FirstLine[1]   ? 0
+           : li < BitBoard::FirstLine[2] ? 1
+           : li < BitBoard::FirstLine[3] ? 2
+                                         : 3;
+}
+
+bool contains(const Pos *points, int count, Pos p)
+{
+    for (int i = 0; i < count; i++)
+        if (points[i] == p)
+            return true;
+    return false;
+}
+
+}  // namespace
+
+VcfSolver::VcfSolver(GameRule gameRule,
+                     int64_t  nodeLimit,
+                     int64_t  msecLimit,
+                     int      depthLimit)
+    : rule(gameRule)
+    , maxNodes(nodeLimit)
+    , maxMsec(msecLimit)
+    , deadline(0)
+    , nodeCount(0)
+    , maxDepth(depthLimit)
+    , winLength(0)
+    , aborted(false)
+    , firstMove(NONE_MOVE)
+    , generation(0)
+{
+    memset(failed, 0, sizeof(failed));
+}
+
+bool VcfSolver::solve(const Position &root)
+{
+    nodeCount = 0;
+    winLength = 0;
+    aborted   = false;
+    firstMove = NONE_MOVE;
+    deadline  = maxMsec ? system_msec() + maxMsec : 0;
+    generation++;  // forget the failures of previous calls
+
+    const Color us = root.get_turn(), them = oppositeColor(us);
+
+    // A winning point of our own is a VCF of one move
+    const WinPoints own = winPoints(root, us);
+    if (own.count) {
+        firstMove = (us << 10) | own.first;
+        winLength = 1;
+        return true;
+    }
+
+    // Two winning points of the opponent can not both be blocked with a four
+    const WinPoints threats = winPoints(root, them);
+    if (threats.count >= 2)
+        return false;
+
+    Position pos = root;
+    return search(pos, threats.first, maxDepth, 0);
+}
+
+bool VcfSolver::outOfBudget()
+{
+    if (++nodeCount > maxNodes)
+        aborted = true;
+    else if (deadline && !(nodeCount & 1023) && system_msec() > deadline)
+        aborted = true;
+    return aborted;
+}
+
+// The side to move has no winning point; threat is the one of the opponent, which any
+// four must block (NO_POS if there is none)
+bool VcfSolver::search(Position &pos, Pos threat, int depth, int ply)
+{
+    if (outOfBudget())
+        return false;
+
+    Failure &fail = failed[pos.get_key() & (FailCount - 1)];
+    if (fail.generation == generation && fail.key == pos.get_key() && fail.depth >= depth)
+        return false;
+
+    const Color us = pos.get_turn(), them = oppositeColor(us);
+
+    Pos       moves[Position::RealBoardSize * Position::RealBoardSize];
+    const int maxMoves = sizeof(moves) / sizeof(moves[0]);
+    int       count    = fourMoves(pos, us, moves, maxMoves);
+    if (threat != NO_POS) {
+        // only the block can be tried, and it has to make a four as well
+        count    = contains(moves, count, threat) ? 1 : 0;
+        moves[0] = threat;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const move_t m = (us << 10) | moves[i];
+        if (rule == RENJU && pos.check_forbidden_move(m))
+            continue;
+
+        pos.move(m);
+        const WinPoints wins  = winPointsThrough(pos, moves[i], us);
+        const move_t    block = (them << 10) | wins.first;
+        bool            won   = false;
+
+        if (wins.count >= 2 || (wins.count == 1 && rule == RENJU
+                                && pos.check_forbidden_move(block))) {
+            // open four or double four, or a block black may not play: five next move
+            won       = true;
+            winLength = ply + 2;
+        }
+        else if (wins.count == 1 && depth > 1) {
+            pos.move(block);
+            const WinPoints counter = winPointsThrough(pos, wins.first, them);
+            if (counter.count < 2)
+                won = search(pos, counter.first, depth - 1, ply + 1);
+            pos.undo();
+        }
+        pos.undo();
+
+        if (won) {
+            if (ply == 0)
+                firstMove = m;
+            return true;
+        }
+        if (aborted)
+            return false;
+    }
+
+    fail = {pos.get_key(), depth, generation};
+    return false;
+}
+
+bool VcfSolver::allowLong(Color side) const
+{
+    return rule == GOMOKU_FIVE_OR_MORE || (rule == RENJU && side == WHITE);
+}
+
+// Whether side wins by playing the empty cell p, given that the line through it along
+// iDir is the one that makes the five (same judgement as the referee)
+bool VcfSolver::winsOn(const Position &pos, Pos p, Color side, int iDir) const
+{
+    const LinePattern lp = pos.linePattern(p, side, iDir, nullptr);
+    if (lp.overline)
+        return allowLong(side);
+    if (!lp.five)
+        return false;
+
+    // a black five that makes an overline on another line is forbidden in renju
+    if (rule == RENJU && side == BLACK)
+        for (int d = 0; d < 4; d++)
+            if (d != iDir && pos.linePattern(p, side, d, nullptr).overline)
+                return false;
+    return true;
+}
+
+// Winning points of side on the four lines through p: after a stone is put on p, these
+// are the only ones that can have appeared
+VcfSolver::WinPoints
+VcfSolver::winPointsThrough(const Position &pos, Pos p, Color side) const
+{
+    const uint32_t *boardLines = BitBoard::board_lines(pos.get_size());
+    WinPoints       wp;
+
+    for (int iDir = 0; iDir < 4; iDir++) {
+        const int li = BitBoard::line_index(p, iDir), k = BitBoard::bit_index(p, iDir);
+        uint32_t  empty = boardLines[li] & ~pos.bitBoard.line(BLACK, li)
+                         & ~pos.bitBoard.line(WHITE, li) & (0x7FFu << (k - 5));
+
+        for (; empty; empty &= empty - 1) {
+            const Pos q = BitBoard::pos_at(li, __builtin_ctz(empty));
+            if (winsOn(pos, q, side, iDir) && !wp.count++)
+                wp.first = q;
+        }
+    }
+    return wp;
+}
+
+// All the winning points of side on the board
+VcfSolver::WinPoints VcfSolver::winPoints(const Position &pos, Color side) const
+{
+    const uint32_t *boardLines = BitBoard::board_lines(pos.get_size());
+    Pos             found[8];
+    WinPoints       wp;
+
+    for (int li = 0; li < BitBoard::FirstLine[4]; li++) {
+        const uint32_t own = pos.bitBoard.line(side, li);
+        if (__builtin_popcount(own) < 4)
+            continue;
+
+        uint32_t empty =
+            boardLines[li] & ~own & ~pos.bitBoard.line(oppositeColor(side), li);
+        for (; empty; empty &= empty - 1) {
+            const int k = __builtin_ctz(empty);
+            if (__builtin_popcount(own & (0x1FFu << (k - 4))) < 4)
+                continue;
+
+            const Pos q = BitBoard::pos_at(li, k);
+            if (contains(found, std::min(wp.count, 8), q))
+                continue;
+            if (winsOn(pos, q, side, plane_of(li))) {
+                if (wp.count < 8)
+                    found[wp.count] = q;
+                wp.count++;
+            }
+        }
+    }
+    wp.first = wp.count ? found[0] : NO_POS;
+    return wp;
+}
+
+// Empty cells where a stone of side makes at least one four (without a five), found
+// line by line from the pattern table
+int VcfSolver::fourMoves(const Position &pos, Color side, Pos *moves, int maxMoves) const
+{
+    const PatternTable &table      = PatternTable::get();
+    const uint32_t     *boardLines = BitBoard::board_lines(pos.get_size());
+    int                 count      = 0;
+
+    for (int li = 0; li < BitBoard::FirstLine[4]; li++) {
+        const uint32_t own = pos.bitBoard.line(side, li);
+        if (__builtin_popcount(own) < 3)
+            continue;
+
+        const uint32_t empty =
+            boardLines[li] & ~own & ~pos.bitBoard.line(oppositeColor(side), li);
+        for (uint32_t e = empty; e; e &= e - 1) {
+            const int k = __builtin_ctz(e);
+            if (__builtin_popcount(own & (0x1FFu << (k - 4))) < 3)
+                continue;
+
+            const LinePattern &lp = table[table.key(own, empty, k)];
+            const Pos          q  = BitBoard::pos_at(li, k);
+            if (lp.fours && !lp.five && count < maxMoves && !contains(moves, count, q))
+                moves[count++] = q;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,78 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "position.h"
+
+#include <cstdint>
+
+// Bounded VCF (victory by continuous fours) search. The side to move attacks with fours
+// only, so that every reply of the opponent is forced, until it gets two winning points
+// at once or a block that black may not play under renju. Renju forbidden points are
+// respected on both sides. The search is sound but not complete: it gives up when the
+// node or time budget runs out, and fours that only complete an overline are not tried.
+class VcfSolver
+{
+public:
+    VcfSolver(GameRule gameRule,
+              int64_t  nodeLimit,
+              int64_t  msecLimit  = 0,
+              int      depthLimit = 30);
+
+    // true if the side to move has a proven VCF (pos itself is left unchanged)
+    bool solve(const Position &pos);
+
+    // of the last successful solve(): first move, and number of own moves up to the five
+    move_t  first_move() const { return firstMove; }
+    int     length() const { return winLength; }
+    int64_t nodes() const { return nodeCount; }
+
+private:
+    static const Pos NO_POS    = 0;     // a wall cell, never a winning point
+    static const int FailCount = 4096;  // direct mapped cache of failed positions
+
+    struct Failure
+    {
+        uint64_t key;
+        int32_t  depth;       // no VCF of up to this many fours
+        uint32_t generation;  // solve() call the entry belongs to
+    };
+
+    // winning points of a side: how many, and the first one found
+    struct WinPoints
+    {
+        int count = 0;
+        Pos first = NO_POS;
+    };
+
+    GameRule rule;
+    int64_t  maxNodes, maxMsec, deadline, nodeCount;
+    int      maxDepth, winLength;
+    bool     aborted;
+    move_t   firstMove;
+    uint32_t generation;
+    Failure  failed[FailCount];
+
+    bool search(Position &pos, Pos threat, int depth, int ply);
+    bool outOfBudget();
+
+    bool      allowLong(Color side) const;
+    bool      winsOn(const Position &pos, Pos p, Color side, int iDir) const;
+    WinPoints winPointsThrough(const Position &pos, Pos p, Color side) const;
+    WinPoints winPoints(const Position &pos, Color side) const;
+    int       fourMoves(const Position &pos, Color side, Pos *moves, int maxMoves) const;
+};
@@ -0,0 +1,226 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the handling of engine output lines while an engine thinks: the former
+// code (prefix tests with strlen(), five find() calls on plain lines, and a stringstream
+// over a copy of every info line), against classify_output() and parse_info(). Lines
+// come from the logs written with -log (what engines sent, " -> "), or from a built-in
+// transcript. Both parsers must agree on depth, score and time. Build from the
+// repository root with:
+//   g++ -std=c++17 -O2 -Icore tools/bench_output.cpp core/engineoutput.cpp
+//       core/codec.cpp core/position.cpp core/bitboard.cpp core/pattern.cpp
+//       core/util.cpp -o bench_output -pthread
+// Usage: bench_output [log files...]
+
+#include "engineoutput.h"
+#include "position.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile long result;  // the sink, stored so that the timed work is kept
+
+// Lines in the style of the info output of a few Gomocup engines
+static const char *const Transcript[] = {
+    "MESSAGE depth 1-3 ev 12 n 102 n/ms 51 tm 2 pv h8",
+    "MESSAGE depth 8-14 ev 35 n 1254K n/ms 1020 tm 1229 pv h8 i9 g7 j10",
+    "MESSAGE depth 12 eval 35 time 812 nodes 1203451 nps 1482000 pv h8 i9 g7",
+    "MESSAGE depth 13 eval 41 time 1630 nodes 2412877 nps 1480293 pv h8 i9",
+    "MESSAGE depth=10 score=cp 31 time=200 nodes=120344",
+    "MESSAGE depth 21 score mate 5 time 2210 pv h8 h9 h10",
+    "MESSAGE Searching move 23 of 41: 7,8",
+    "DEBUG hash table 16 MB, 2 threads",
+    "depth 9 eval -12 time 400",
+    "Depth 11 Eval -20",
+    "UNKNOWN command",
+    "7,7",
+};
+
+namespace reference {
+
+enum OutputType { OT_DIRECT, OT_UNKNOWN, OT_ERROR, OT_MESSAGE, OT_DEBUG, OT_SUGGEST };
+
+OutputType process_common_output(const char *line, const char *&tail)
+{
+    OutputType type = OT_DIRECT;
+
+    if ((tail = string_prefix(line, "MESSAGE")))
+        type = OT_MESSAGE;
+    else if ((tail = string_prefix(line, "DEBUG")))
+        type = OT_DEBUG;
+    else if ((tail = string_prefix(line, "UNKNOWN")))
+        type = OT_UNKNOWN;
+    else if ((tail = string_prefix(line, "ERROR")))
+        type = OT_ERROR;
+    else if ((tail = string_prefix(line, "SUGGEST")))
+        type = OT_SUGGEST;
+    else
+        tail = line;
+
+    if (type != OT_DIRECT && strlen(tail) > 0)
+        tail += 1;
+    return type;
+}
+
+void parse_thinking_message(const char *line, Info &info)
+{
+    std::string temp = line;
+    for (char &c : temp)
+        if (c == '=')
+            c = ' ';
+
+    std::stringstream ss(temp);
+    std::string       token;
+
+    while (ss >> token) {
+        if (token == "depth" || token == "Depth") {
+            if (ss >> token)
+                info.depth = std::atoi(token.c_str());
+        }
+        else if (token == "time" || token == "Time") {
+            if (ss >> token)
+                info.time = std::atoll(token.c_str());
+        }
+        else if (token == "score" || token == "eval" || token == "Eval") {
+            std::string val;
+            if (ss >> val) {
+                if (val == "cp") {
+                    if (ss >> val)
+                        info.score = std::atoi(val.c_str());
+                }
+                else if (val == "mate") {
+                    if (ss >> val) {
+                        int m      = std::atoi(val.c_str());
+                        info.score = m > 0 ? SCORE_MATE - m : -SCORE_MATE - m;
+                    }
+                }
+                else {
+                    try {
+                        size_t idx;
+                        int    s = std::stoi(val, &idx);
+                        if (idx == val.size())
+                            info.score = s;
+                    }
+                    catch (...) {
+                    }
+                }
+            }
+        }
+    }
+}
+
+// What Engine::bestmove() did with a line
+bool handle(const std::string &line, Info &info)
+{
+    const char *tail;
+    OutputType  type = process_common_output(line.c_str(), tail);
+
+    if (type == OT_MESSAGE)
+        parse_thinking_message(tail, info);
+    else if (type == OT_DIRECT) {
+        if (line.find("Eval") != std::string::npos
+            || line.find("eval") != std::string::npos
+            || line.find("score") != std::string::npos
+            || line.find("Depth") != std::string::npos
+            || line.find("depth") != std::string::npos)
+            parse_thinking_message(line.c_str(), info);
+
+        return Position::is_valid_move_gomostr(line);
+    }
+    return false;
+}
+
+}  // namespace reference
+
+// What Engine::bestmove() does with a line
+static bool handle(const std::string &line, Info &info)
+{
+    std::string_view tail;
+    OutputType       type = classify_output(line, tail);
+
+    if (type == OT_MESSAGE)
+        parse_info(tail, info);
+    else if (type == OT_DIRECT) {
+        if (Position::is_valid_move_gomostr(line))
+            return true;
+        parse_info(line, info);
+    }
+    return false;
+}
+
+// Engine output recorded in a log: the text after "<time>: <name> -> "
+static void load_log(const char *fileName, std::vector<std::string> &lines)
+{
+    FILE *in;
+    DIE_IF(0, !(in = fopen(fileName, "r" FOPEN_TEXT)));
+
+    std::string line;
+    while (string_getline(line, in)) {
+        const size_t arrow = line.find(" -> ");
+        if (arrow != std::string::npos)
+            lines.push_back(line.substr(arrow + 4));
+    }
+
+    DIE_IF(0, fclose(in) < 0);
+}
+
+int main(int argc, const char **argv)
+{
+    std::vector<std::string> lines;
+    for (int i = 1; i < argc; i++)
+        load_log(argv[i], lines);
+    if (argc == 1)
+        lines.assign(std::begin(Transcript), std::end(Transcript));
+    if (lines.empty())
+        DIE("no engine output found\n");
+
+    // Same results, line by line
+    for (const std::string &line : lines) {
+        Info a = {}, b = {};
+        if (reference::handle(line, a) != handle(line, b) || a.depth != b.depth
+            || a.score != b.score || a.time != b.time)
+            DIE("parsers disagree on '%s'\n", line.c_str());
+    }
+
+    const int repeat = std::max<int>(1, int(2000000 / lines.size()));
+    double    ns[2]  = {};
+    long      sink   = 0;
+
+    for (int v = 0; v < 2; v++) {
+        Info       info = {};
+        const auto t0   = Clock::now();
+        for (int r = 0; r < repeat; r++)
+            for (const std::string &line : lines)
+                sink += v ? handle(line, info) : reference::handle(line, info);
+        ns[v] = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        sink += info.depth + info.score;
+    }
+
+    const double n = double(lines.size()) * repeat;
+    printf("%zu lines, %d passes\n", lines.size(), repeat);
+    printf("before: %8.1f ns/line\n", ns[0] / n);
+    printf("after:  %8.1f ns/line\n", ns[1] / n);
+    result = sink;
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the rule checks run by the referee on every ply: the generic Position
+// calls (size and rule decided at runtime), against the RuleKernel picked for the
+// tournament options. Build from the repository root with:
+//   g++ -std=c++17 -O2 -DNDEBUG -Icore tools/bench_rules.cpp core/position.cpp
+//       core/bitboard.cpp core/pattern.cpp core/codec.cpp core/util.cpp -o bench_rules
+//       -pthread
+
+#include "position.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile long result;  // the sink, stored so that the timed work is kept
+
+// Random games where most moves are played next to an earlier stone, so that lines
+// and threats do form. A game stops on the first five.
+static std::vector<std::vector<move_t>>
+make_games(int boardSize, GameRule rule, int count, uint64_t seed)
+{
+    std::vector<std::vector<move_t>> games;
+    const RuleKernel                &rules = RuleKernel::get(boardSize, rule);
+
+    for (int g = 0; g < count; g++) {
+        Position            pos(boardSize);
+        std::vector<move_t> moves;
+
+        while (pos.get_moves_left() > 0) {
+            move_t m;
+            do {
+                int x = prng(seed) % boardSize, y = prng(seed) % boardSize;
+                if (!moves.empty() && prng(seed) % 4) {
+                    Pos near = PosFromMove(moves[prng(seed) % moves.size()]);
+                    x        = CoordX(near) + int(prng(seed) % 5) - 2;
+                    y        = CoordY(near) + int(prng(seed) % 5) - 2;
+                    if (x < 0 || y < 0 || x >= boardSize || y >= boardSize)
+                        continue;
+                }
+                m = (pos.get_turn() << 10) | POS(x, y);
+            } while (!pos.is_legal_move(m));
+
+            if (rules.forbidden(pos, m))
+                continue;
+            pos.move(m);
+            moves.push_back(m);
+            if (rules.five_lastmove(pos))
+                break;
+        }
+        games.push_back(moves);
+    }
+
+    return games;
+}
+
+// What the referee did per ply before rule kernels
+static int generic_ply(Position &pos, GameRule rule, move_t next, bool fullScan)
+{
+    bool allowLong = rule == GOMOKU_FIVE_OR_MORE
+                     || (rule == RENJU && ColorFromMove(next) == BLACK);  // white moved
+    int  r         = pos.check_five_in_line_lastmove(allowLong);
+    if (fullScan)
+        r += pos.check_five_in_line_side(oppositeColor(ColorFromMove(next)), allowLong);
+    if (rule == RENJU)
+        r += pos.check_forbidden_move(next);
+    return r;
+}
+
+static int kernel_ply(Position &pos, const RuleKernel &rules, move_t next, bool fullScan)
+{
+    int r = rules.five_lastmove(pos);
+    if (fullScan)
+        r += rules.five_full_scan(pos);
+    return r + rules.forbidden(pos, next);
+}
+
+int main()
+{
+    const int      sizes[] = {15, 19, 20, 17};
+    const GameRule ruleList[] = {GOMOKU_FIVE_OR_MORE, GOMOKU_EXACT_FIVE, RENJU};
+    const int      repeat  = 20;
+    long           sink    = 0;
+
+    printf("%4s %4s %9s | %12s %12s | %12s %12s\n",
+           "size",
+           "rule",
+           "plies",
+           "generic",
+           "kernel",
+           "generic+scan",
+           "kernel+scan");
+
+    for (int size : sizes)
+        for (GameRule rule : ruleList) {
+            const RuleKernel &rules = RuleKernel::get(size, rule);
+            const auto        games = make_games(size, rule, 200, 1234 + size);
+            double            ns[4] = {};
+            long              plies = 0;
+
+            for (const auto &moves : games) {
+                Position pos(size);
+                for (size_t i = 0; i + 1 < moves.size(); i++) {
+                    pos.move(moves[i]);
+                    const move_t next = moves[i + 1];
+                    for (int v = 0; v < 4; v++) {
+                        const bool fullScan = v >= 2;
+                        auto       t0       = Clock::now();
+                        for (int r = 0; r < repeat; r++)
+                            sink += v % 2 ? kernel_ply(pos, rules, next, fullScan)
+                                          : generic_ply(pos, rule, next, fullScan);
+                        ns[v] += std::chrono::duration<double, std::nano>(Clock::now() - t0)
+                                     .count();
+                    }
+                    plies++;
+                }
+            }
+
+            const double n = double(plies) * repeat;
+            printf("%4d %4d %9ld | %9.1f ns %9.1f ns | %9.1f ns %9.1f ns\n",
+                   size,
+                   (int)rule,
+                   plies,
+                   ns[0] / n,
+                   ns[1] / n,
+                   ns[2] / n,
+                   ns[3] / n);
+        }
+
+    result = sink;
+    return 0;
+}
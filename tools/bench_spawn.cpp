@@ -0,0 +1,130 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of engine (re)start latency, which a tournament pays on every crash, timeout
+// or pair change: Engine::start() (spawn and ABOUT) followed by terminate() (END), timed
+// in a process made large like the GUI, with a ballast of touched memory and idle
+// threads. A bare fork()+exec and vfork()+exec of /bin/true are timed as well, to show
+// what the spawn method costs by itself. Build from the repository root with:
+//   g++ -std=c++17 -O2 -Icore tools/bench_spawn.cpp core/engine.cpp core/position.cpp
+//       core/bitboard.cpp core/pattern.cpp core/codec.cpp core/reactor.cpp
+//       core/util.cpp core/workers.cpp core/engineoutput.cpp core/aboutcache.cpp
+//       core/extern/xxhash.c -o bench_spawn -pthread
+// Usage: bench_spawn <engine command> [restarts] [ballast MB]
+
+#include "engine.h"
+#include "util.h"
+#include "workers.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsed_us(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+// Average time to spawn /bin/true and reap it
+static double bare_spawn_us(bool useVfork, int count)
+{
+    char        arg0[] = "true";
+    char *const argv[] = {arg0, nullptr};
+    const auto  start  = Clock::now();
+
+    for (int i = 0; i < count; i++) {
+        const pid_t pid = useVfork ? vfork() : fork();
+        DIE_IF(0, pid < 0);
+        if (pid == 0) {
+            execvp(argv[0], argv);
+            _exit(EXIT_FAILURE);
+        }
+        DIE_IF(0, waitpid(pid, nullptr, 0) < 0);
+    }
+
+    return elapsed_us(start) / count;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <engine command> [restarts] [ballast MB]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char  *cmd      = argv[1];
+    const int    restarts = argc > 2 ? atoi(argv[2]) : 200;
+    const size_t ballast  = argc > 3 ? (size_t)atol(argv[3]) : 1024;
+
+    // Ballast: every page touched, so that fork() has page tables to copy
+    std::vector<char> memory(ballast << 20);
+    for (size_t i = 0; i < memory.size(); i += 4096)
+        memory[i] = char(i);
+
+    // Idle threads, like the ones of the GUI and the web server
+    const int                IdleThreads = 8;
+    std::mutex               mtx;
+    std::condition_variable  cv;
+    bool                     quit = false;
+    std::vector<std::thread> idle;
+    for (int i = 0; i < IdleThreads; i++)
+        idle.emplace_back([&] {
+            std::unique_lock lock(mtx);
+            cv.wait(lock, [&] { return quit; });
+        });
+
+    printf("ballast: %zu MB, %d idle threads\n", ballast, IdleThreads);
+    printf("fork+exec:  %8.1f us/spawn\n", bare_spawn_us(false, restarts));
+    printf("vfork+exec: %8.1f us/spawn\n", bare_spawn_us(true, restarts));
+    fflush(stdout);
+
+    // Engine restarts, with the "Load engine" lines of start() sent to /dev/null
+    const int stdoutFd = dup(STDOUT_FILENO);
+    DIE_IF(0, !freopen("/dev/null", "w", stdout));
+
+    Worker     w(0, "");
+    Engine     engine(&w, false, nullptr);
+    const auto start = Clock::now();
+    for (int i = 0; i < restarts; i++) {
+        engine.start(cmd, "", 3000);
+        engine.terminate();
+    }
+    const double us = elapsed_us(start) / restarts;
+
+    fflush(stdout);
+    DIE_IF(0, dup2(stdoutFd, STDOUT_FILENO) < 0);
+    printf("engine:     %8.1f us/restart (spawn, ABOUT and END)\n", us);
+
+    {
+        std::lock_guard lock(mtx);
+        quit = true;
+    }
+    cv.notify_all();
+    for (std::thread &th : idle)
+        th.join();
+
+    return memory[4096] == 1;  // keep the ballast alive
+}
@@ -0,0 +1,96 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of Position::transform() (permutation tables, stones walked once) against
+// the transform it replaced (every stone taken off and put back by coordinates, see
+// rules_reference.h), on the same Position with its key and bitboards. Positions are
+// random, with a given number of stones; both results must have the same key. Build
+// from the repository root with:
+//   g++ -std=c++17 -O2 -DNDEBUG -Icore tools/bench_transform.cpp core/position.cpp
+//       core/bitboard.cpp core/pattern.cpp core/codec.cpp core/util.cpp
+//       -o bench_transform -pthread
+
+#include "position.h"
+#include "rules_reference.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static Position random_position(int boardSize, int stones, uint64_t &seed)
+{
+    Position pos(boardSize);
+    while (pos.get_move_count() < stones) {
+        const move_t m =
+            pos.get_turn() << 10 | POS(prng(seed) % boardSize, prng(seed) % boardSize);
+        if (pos.is_legal_move(m))
+            pos.move(m);
+    }
+    return pos;
+}
+
+int main()
+{
+    const int sizes[]  = {15, 20};
+    const int stones[] = {10, 40, 100};
+    const int count    = 2000;
+    uint64_t  seed     = 1;
+
+    printf("%4s %6s | %12s %12s\n", "size", "stones", "before", "after");
+
+    for (int size : sizes)
+        for (int n : stones) {
+            std::vector<Position> positions;
+            for (int i = 0; i < count; i++)
+                positions.push_back(random_position(size, n, seed));
+
+            double ns[2] = {};
+            for (int v = 0; v < 2; v++) {
+                std::vector<Position> copies = positions;
+                const auto            t0     = Clock::now();
+                for (Position &pos : copies)
+                    for (int t = IDENTITY + 1; t < NB_TRANS; t++) {
+                        if (v)
+                            pos.transform((TransformType)t);
+                        else
+                            reference::transform_position(pos, (TransformType)t);
+                    }
+                ns[v] = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+
+                if (v) {
+                    // both paths end on the same key
+                    std::vector<Position> before = positions;
+                    for (size_t i = 0; i < positions.size(); i++) {
+                        for (int t = IDENTITY + 1; t < NB_TRANS; t++)
+                            reference::transform_position(before[i], (TransformType)t);
+                        DIE_IF(0, before[i].get_key() != copies[i].get_key());
+                    }
+                }
+            }
+
+            const double transforms = double(count) * (NB_TRANS - 1);
+            printf("%4d %6d | %9.1f ns %9.1f ns\n",
+                   size,
+                   n,
+                   ns[0] / transforms,
+                   ns[1] / transforms);
+        }
+
+    return 0;
+}
@@ -0,0 +1,377 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Differential fuzzer of the rule code: plays random and adversarial games on every
+// board size and rule, and after each move compares the optimized checks (rule kernels,
+// bitboard scans, pattern table renju) with the frozen reference of rules_reference.h.
+// On the first disagreement it shrinks the game to a minimal move sequence, prints it
+// and exits with status 1. It also reports positions per second of both paths. Build
+// from the repository root with:
+//   g++ -std=c++17 -O2 -Icore tools/fuzz_rules.cpp core/position.cpp core/bitboard.cpp
+//       core/pattern.cpp core/codec.cpp core/util.cpp -o fuzz_rules -pthread
+// Usage: fuzz_rules [games per size, rule and mode (default 10)] [seed]
+
+#include "position.h"
+#include "rules_reference.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+enum Check { CHECK_FIVE, CHECK_FORBIDDEN, CHECK_TRANSFORM, NB_CHECK };
+
+static const char *CheckName[NB_CHECK] = {"five", "forbidden", "transform"};
+
+// positions and nanoseconds spent per check, by the reference and the optimized path
+static double        timeRef[NB_CHECK], timeOpt[NB_CHECK];
+static long          positions[NB_CHECK];
+static volatile long sink;  // keeps the optimizer from dropping unused results
+
+static bool allow_long(GameRule rule, Color side)
+{
+    return rule == GOMOKU_FIVE_OR_MORE || (rule == RENJU && side == WHITE);
+}
+
+static double since(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+}
+
+// Compares one check on the current position. Returns a description of the first
+// disagreement, or an empty string.
+static std::string
+compare(Position &pos, reference::Board &ref, GameRule rule, Check check, bool timed)
+{
+    const int size = pos.get_size();
+    if (!pos.get_move_count())
+        return {};
+    const Color side = ColorFromMove(pos.get_hist_moves()[pos.get_move_count() - 1]);
+
+    switch (check) {
+    case CHECK_FIVE: {
+        const RuleKernel &rules = RuleKernel::get(size, rule);
+        const bool        al    = allow_long(rule, side);
+
+        auto       t0       = Clock::now();
+        const bool expected = ref.has_five(side, al);
+        if (timed)
+            timeRef[check] += since(t0);
+
+        t0                  = Clock::now();
+        const bool lastmove = rules.five_lastmove(pos);
+        const bool fullScan = rules.five_full_scan(pos);
+        if (timed)
+            timeOpt[check] += since(t0);
+        const bool generic    = pos.check_five_in_line_lastmove(al);
+        const bool genericAll = pos.check_five_in_line_side(side, al);
+
+        if (lastmove != expected || fullScan != expected || generic != expected
+            || genericAll != expected)
+            return format("reference five %d, kernel lastmove %d, kernel full scan %d, "
+                          "lastmove %d, side scan %d",
+                          expected,
+                          lastmove,
+                          fullScan,
+                          generic,
+                          genericAll);
+        return {};
+    }
+
+    case CHECK_FORBIDDEN: {
+        static ForbiddenType expected[Position::MaxBoardSizeSqr];
+        static ForbiddenType map[Position::MaxBoardSizeSqr];
+
+        auto t0 = Clock::now();
+        for (int x = 0; x < size; x++)
+            for (int y = 0; y < size; y++) {
+                const Pos p = POS(x, y);
+                expected[p] = ref.at(p) == EMPTY ? ref.forbidden(p) : FORBIDDEN_NONE;
+            }
+        if (timed)
+            timeRef[check] += since(t0);
+
+        t0 = Clock::now();
+        pos.forbidden_map(map);
+        if (timed)
+            timeOpt[check] += since(t0);
+
+        for (int x = 0; x < size; x++)
+            for (int y = 0; y < size; y++) {
+                const Pos p = POS(x, y);
+                if (ref.at(p) != EMPTY)
+                    continue;
+                const ForbiddenType single = pos.check_forbidden_move(BLACK << 10 | p);
+                if (map[p] != expected[p] || single != expected[p])
+                    return format("cell %s: reference %d, forbidden map %d, single move %d",
+                                  pos.move_to_gomostr(p),
+                                  (int)expected[p],
+                                  (int)map[p],
+                                  (int)single);
+            }
+        return {};
+    }
+
+    case CHECK_TRANSFORM: {
+        const uint64_t canonical = pos.get_canonical_key();
+
+        for (int t = IDENTITY; t < NB_TRANS; t++) {
+            const TransformType type = (TransformType)t;
+
+            reference::Board refCopy = ref;
+            refCopy.transform(type);
+
+            // both paths transform a Position, with its key and bitboards
+            Position refPos = pos;
+            auto     t0     = Clock::now();
+            reference::transform_position(refPos, type);
+            if (timed)
+                timeRef[check] += since(t0);
+
+            Position copy = pos;
+            t0            = Clock::now();
+            copy.transform(type);
+            if (timed)
+                timeOpt[check] += since(t0);
+
+            // the transformed history must describe the reference board
+            Position replay(size);
+            for (int i = 0; i < copy.get_move_count(); i++) {
+                const move_t m = copy.get_hist_moves()[i];
+                if (refCopy.at(PosFromMove(m)) != ColorFromMove(m))
+                    return format("transform %d: move %s is not on the reference board",
+                                  t,
+                                  pos.move_to_gomostr(m));
+                replay.move(m);
+            }
+            if (copy.get_key() != replay.get_key()
+                || refPos.get_key() != replay.get_key())
+                return format("transform %d: key %016llx, reference %016llx, replayed "
+                              "%016llx",
+                              t,
+                              (unsigned long long)copy.get_key(),
+                              (unsigned long long)refPos.get_key(),
+                              (unsigned long long)replay.get_key());
+            if (copy.get_canonical_key() != canonical)
+                return format("transform %d: canonical key %016llx instead of %016llx",
+                              t,
+                              (unsigned long long)copy.get_canonical_key(),
+                              (unsigned long long)canonical);
+            // open windows are kept as they are, bitboards rebuilt
+            for (int c = BLACK; c <= WHITE; c++)
+                if (copy.get_open_windows((Color)c) != replay.get_open_windows((Color)c)
+                    || copy.check_five_in_line_side((Color)c)
+                           != replay.check_five_in_line_side((Color)c))
+                    return format("transform %d: colour %d has %d open windows and five "
+                                  "%d, replayed %d and %d",
+                                  t,
+                                  c,
+                                  copy.get_open_windows((Color)c),
+                                  copy.check_five_in_line_side((Color)c),
+                                  replay.get_open_windows((Color)c),
+                                  replay.check_five_in_line_side((Color)c));
+            sink += copy.get_open_windows(BLACK);
+        }
+        return {};
+    }
+
+    default: return {};
+    }
+}
+
+// Replays a sequence of cells (colours alternate from black) and runs one check on the
+// final position. Sequences with an illegal move, or a five before the last move, are
+// not valid games: they report no failure.
+static std::string replay(const std::vector<Pos> &cells, int size, GameRule rule, Check check)
+{
+    Position         pos(size);
+    reference::Board ref(size);
+
+    for (size_t i = 0; i < cells.size(); i++) {
+        const move_t m = pos.get_turn() << 10 | cells[i];
+        if (!pos.is_legal_move(m))
+            return {};
+        if (ref.has_five(BLACK, true) || ref.has_five(WHITE, true))
+            return {};
+        pos.move(m);
+        ref.set(cells[i], ColorFromMove(m));
+    }
+    return compare(pos, ref, rule, check, false);
+}
+
+[[noreturn]] static void
+report(std::vector<Pos> cells, int size, GameRule rule, Check check)
+{
+    // shortest failing prefix, then drop moves while it still fails: single moves, and
+    // pairs of a black and a white move, which keep the colours of the other moves
+    while (cells.size() > 1) {
+        std::vector<Pos> prefix(cells.begin(), cells.end() - 1);
+        if (replay(prefix, size, rule, check).empty())
+            break;
+        cells = prefix;
+    }
+    for (bool shrunk = true; shrunk;) {
+        shrunk = false;
+        for (size_t i = 0; i < cells.size(); i++)
+            for (size_t j = i; j < cells.size(); j += j == i ? 1 : 2) {
+                std::vector<Pos> shorter = cells;
+                if (j != i)
+                    shorter.erase(shorter.begin() + j);
+                shorter.erase(shorter.begin() + i);
+                if (!replay(shorter, size, rule, check).empty()) {
+                    cells  = shorter;
+                    shrunk = true;
+                    j      = i;
+                }
+            }
+    }
+
+    Position pos(size);
+    for (Pos p : cells)
+        pos.move(pos.get_turn() << 10 | p);
+    printf("\nMISMATCH in %s check, size %d, rule %d, %zu moves\n",
+           CheckName[check],
+           size,
+           (int)rule,
+           cells.size());
+    printf("%s\n", replay(cells, size, rule, check).c_str());
+    printf("moves: %s\n", pos.to_opening_str(OPENING_POS).c_str());
+    pos.print();
+    exit(1);
+}
+
+// Picks the next move: uniform for random games. Adversarial games mostly play on
+// cells where either side makes a four or a three, or else next to an earlier stone,
+// so that the tricky renju shapes (and overlines) come up often.
+static move_t pick_move(const Position &pos,
+                        GameRule        rule,
+                        bool            adversarial,
+                        uint64_t       &seed)
+{
+    const int size = pos.get_size();
+
+    if (adversarial && pos.get_move_count() && prng(seed) % 4) {
+        ThreatFeatures features;
+        pos.threat_features(rule, features);
+
+        std::vector<Pos> cells;
+        for (int c = BLACK; c <= WHITE; c++)
+            for (int t = THREAT_OPEN_FOUR; t < NB_THREAT; t++)
+                for (int x = 0; x < size; x++)
+                    for (int y = 0; y < size; y++)
+                        if (features.has((Color)c, (ThreatType)t, POS(x, y)))
+                            cells.push_back(POS(x, y));
+        if (!cells.empty())
+            return pos.get_turn() << 10 | cells[prng(seed) % cells.size()];
+    }
+
+    for (;;) {
+        int x = prng(seed) % size, y = prng(seed) % size;
+        if (adversarial && pos.get_move_count()) {
+            const int n    = pos.get_move_count();
+            const Pos near = PosFromMove(pos.get_hist_moves()[prng(seed) % n]);
+            x              = CoordX(near) + int(prng(seed) % 5) - 2;
+            y              = CoordY(near) + int(prng(seed) % 5) - 2;
+            if (x < 0 || y < 0 || x >= size || y >= size)
+                continue;
+        }
+        const move_t m = pos.get_turn() << 10 | POS(x, y);
+        if (pos.is_legal_move(m))
+            return m;
+    }
+}
+
+// Whether black has an empty cell that is not forbidden
+static bool black_can_move(const Position &pos)
+{
+    ForbiddenType map[Position::MaxBoardSizeSqr];
+    pos.forbidden_map(map);
+
+    const int size = pos.get_size();
+    for (int x = 0; x < size; x++)
+        for (int y = 0; y < size; y++)
+            if (pos.is_legal_move(BLACK << 10 | POS(x, y))
+                && map[POS(x, y)] == FORBIDDEN_NONE)
+                return true;
+    return false;
+}
+
+static void play(int size, GameRule rule, bool adversarial, uint64_t &seed)
+{
+    Position         pos(size);
+    reference::Board ref(size);
+    std::vector<Pos> cells;
+
+    while (pos.get_moves_left() > 0) {
+        const move_t m = pick_move(pos, rule, adversarial, seed);
+        // the referee ends the game on a forbidden move: random games avoid them
+        const bool forbidden = rule == RENJU && ColorFromMove(m) == BLACK
+                               && pos.check_forbidden_move(m) != FORBIDDEN_NONE;
+        if (forbidden && !adversarial) {
+            if (!black_can_move(pos))  // every empty cell is forbidden: the game is over
+                break;
+            continue;
+        }
+
+        pos.move(m);
+        ref.set(PosFromMove(m), ColorFromMove(m));
+        cells.push_back(PosFromMove(m));
+
+        for (int c = 0; c < NB_CHECK; c++) {
+            const Check check = (Check)c;
+            if (check == CHECK_FORBIDDEN && rule != RENJU)
+                continue;
+            if (!compare(pos, ref, rule, check, true).empty())
+                report(cells, size, rule, check);
+            positions[check]++;
+        }
+
+        if (forbidden || ref.has_five(ColorFromMove(m), allow_long(rule, ColorFromMove(m))))
+            break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const int games = argc > 1 ? atoi(argv[1]) : 10;
+    uint64_t  seed  = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1;
+
+    for (GameRule rule : ALL_VALID_RULES)
+        for (int size = 5; size <= Position::RealBoardSize; size++) {
+            for (int g = 0; g < games; g++) {
+                play(size, rule, false, seed);
+                play(size, rule, true, seed);
+            }
+            printf("rule %d, size %2d: ok\n", (int)rule, size);
+            fflush(stdout);
+        }
+    printf("\n%10s %10s | %16s %16s\n",
+           "check",
+           "positions",
+           "reference pos/s",
+           "optimized pos/s");
+    for (int c = 0; c < NB_CHECK; c++)
+        printf("%10s %10ld | %16.0f %16.0f\n",
+               CheckName[c],
+               positions[c],
+               positions[c] * 1e9 / timeRef[c],
+               positions[c] * 1e9 / timeOpt[c]);
+    return 0;
+}
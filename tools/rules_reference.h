@@ -0,0 +1,322 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Frozen reference copy of the rule code as it was before the bitboard and pattern table
+// rewrites: plain board walks for fives, the recursive renju helpers that put stones on
+// the board and take them back, and transforms by coordinates. It is only meant to be
+// slow and obviously right, as the oracle of tools/fuzz_rules.cpp. Do not optimize it.
+
+#pragma once
+
+#include "position.h"
+
+#include <cstring>
+
+namespace reference {
+
+const int Direction[4] = {1, 31, 32, 33};
+
+inline Pos transform_pos(Pos p, int boardSize, TransformType type)
+{
+    int x = CoordX(p), y = CoordY(p);
+    int s = boardSize - 1;
+    switch (type) {
+    case ROTATE_90: return POS(y, s - x);
+    case ROTATE_180: return POS(s - x, s - y);
+    case ROTATE_270: return POS(s - y, x);
+    case FLIP_X: return POS(x, s - y);
+    case FLIP_Y: return POS(s - x, y);
+    case FLIP_XY: return POS(y, x);
+    case FLIP_YX: return POS(s - y, s - x);
+    default: return POS(x, y);
+    }
+}
+
+class Board
+{
+public:
+    explicit Board(int size) : boardSize(size)
+    {
+        for (int i = 0; i < Position::MaxBoardSizeSqr; i++)
+            board[i] = (CoordX(i) >= 0 && CoordX(i) < size && CoordY(i) >= 0
+                        && CoordY(i) < size)
+                           ? EMPTY
+                           : WALL;
+    }
+
+    Color at(Pos pos) const { return board[pos]; }
+    void  set(Pos pos, Color piece) { board[pos] = piece; }
+    void  del(Pos pos) { board[pos] = EMPTY; }
+
+    // a run of five (or more, if allowed) stones of side anywhere on the board
+    bool has_five(Color side, bool allowLong) const
+    {
+        for (int x = 0; x < boardSize; x++)
+            for (int y = 0; y < boardSize; y++) {
+                Pos pos = POS(x, y);
+                if (board[pos] != side)
+                    continue;
+                for (int dir : Direction) {
+                    if (board[pos - dir] == side)
+                        continue;  // not the start of the run
+                    int count = 1;
+                    while (board[pos + dir * count] == side)
+                        count++;
+                    if (count == 5 || (allowLong && count > 5))
+                        return true;
+                }
+            }
+        return false;
+    }
+
+    void transform(TransformType type)
+    {
+        Color before[Position::MaxBoardSizeSqr];
+        memcpy(before, board, sizeof(before));
+        for (int x = 0; x < boardSize; x++)
+            for (int y = 0; y < boardSize; y++)
+                board[transform_pos(POS(x, y), boardSize, type)] = before[POS(x, y)];
+    }
+
+    ForbiddenType forbidden(Pos pos)
+    {
+        if (isDoubleThree(pos, BLACK))
+            return DOUBLE_THREE;
+        else if (isDoubleFour(pos, BLACK))
+            return DOUBLE_FOUR;
+        else if (isOverline(pos, BLACK))
+            return OVERLINE;
+        else
+            return FORBIDDEN_NONE;
+    }
+
+private:
+    enum OpenFourType { OF_NONE, OF_TRUE, OF_LONG };
+
+    int   boardSize;
+    Color board[Position::MaxBoardSizeSqr];
+
+    bool isFive(Pos pos, Color piece)
+    {
+        if (board[pos] != EMPTY)
+            return false;
+        for (int iDir = 0; iDir < 4; iDir++)
+            if (isFive(pos, piece, iDir))
+                return true;
+        return false;
+    }
+
+    bool isFive(Pos pos, Color piece, int iDir)
+    {
+        if (board[pos] != EMPTY)
+            return false;
+
+        int i, j;
+        int count = 1;
+        for (i = 1; i < 6; i++) {
+            if (board[pos - Direction[iDir] * i] == piece)
+                count++;
+            else
+                break;
+        }
+        for (j = 1; j < 7 - i; j++) {
+            if (board[pos + Direction[iDir] * j] == piece)
+                count++;
+            else
+                break;
+        }
+        return count == 5;
+    }
+
+    bool isOverline(Pos pos, Color piece)
+    {
+        if (board[pos] != EMPTY)
+            return false;
+
+        for (int dir : Direction) {
+            int i, j;
+            int count = 1;
+            for (i = 1; i < 6; i++) {
+                if (board[pos - dir * i] == piece)
+                    count++;
+                else
+                    break;
+            }
+            for (j = 1; j < 7 - i; j++) {
+                if (board[pos + dir * j] == piece)
+                    count++;
+                else
+                    break;
+            }
+            if (count > 5)
+                return true;
+        }
+        return false;
+    }
+
+    bool isFour(Pos pos, Color piece, int iDir)
+    {
+        if (board[pos] != EMPTY || isFive(pos, piece)
+            || (piece == BLACK && isOverline(pos, BLACK)))
+            return false;
+
+        bool four = false;
+        set(pos, piece);
+
+        int i, j;
+        for (i = 1; i < 5; i++) {
+            Pos posi = pos - Direction[iDir] * i;
+            if (board[posi] == piece)
+                continue;
+            else if (board[posi] == EMPTY && isFive(posi, piece, iDir))
+                four = true;
+            break;
+        }
+        for (j = 1; !four && j < 6 - i; j++) {
+            Pos posi = pos + Direction[iDir] * j;
+            if (board[posi] == piece)
+                continue;
+            else if (board[posi] == EMPTY && isFive(posi, piece, iDir))
+                four = true;
+            break;
+        }
+
+        del(pos);
+        return four;
+    }
+
+    OpenFourType isOpenFour(Pos pos, Color piece, int iDir)
+    {
+        if (board[pos] != EMPTY || isFive(pos, piece)
+            || (piece == BLACK && isOverline(pos, BLACK)))
+            return OF_NONE;
+
+        set(pos, piece);
+
+        int i, j;
+        int count = 1;
+        int five  = 0;
+        for (i = 1; i < 5; i++) {
+            Pos posi = pos - Direction[iDir] * i;
+            if (board[posi] == piece) {
+                count++;
+                continue;
+            }
+            else if (board[posi] == EMPTY)
+                five += isFive(posi, piece, iDir);
+            break;
+        }
+        for (j = 1; five && j < 6 - i; j++) {
+            Pos posi = pos + Direction[iDir] * j;
+            if (board[posi] == piece) {
+                count++;
+                continue;
+            }
+            else if (board[posi] == EMPTY)
+                five += isFive(posi, piece, iDir);
+            break;
+        }
+
+        del(pos);
+        return five == 2 ? (count == 4 ? OF_TRUE : OF_LONG) : OF_NONE;
+    }
+
+    bool isOpenThree(Pos pos, Color piece, int iDir)
+    {
+        if (board[pos] != EMPTY || isFive(pos, piece)
+            || (piece == BLACK && isOverline(pos, BLACK)))
+            return false;
+
+        bool openthree = false;
+        set(pos, piece);
+
+        int i, j;
+        for (i = 1; i < 5; i++) {
+            Pos posi = pos - Direction[iDir] * i;
+            if (board[posi] == piece)
+                continue;
+            else if (board[posi] == EMPTY && isOpenFour(posi, piece, iDir) == OF_TRUE
+                     && !isDoubleFour(posi, piece) && !isDoubleThree(posi, piece))
+                openthree = true;
+            break;
+        }
+        for (j = 1; !openthree && j < 6 - i; j++) {
+            Pos posi = pos + Direction[iDir] * j;
+            if (board[posi] == piece)
+                continue;
+            else if (board[posi] == EMPTY && isOpenFour(posi, piece, iDir) == OF_TRUE
+                     && !isDoubleFour(posi, piece) && !isDoubleThree(posi, piece))
+                openthree = true;
+            break;
+        }
+
+        del(pos);
+        return openthree;
+    }
+
+    bool isDoubleFour(Pos pos, Color piece)
+    {
+        if (board[pos] != EMPTY || isFive(pos, piece))
+            return false;
+
+        int nFour = 0;
+        for (int iDir = 0; iDir < 4; iDir++) {
+            if (isOpenFour(pos, piece, iDir) == OF_LONG)
+                nFour += 2;
+            else if (isFour(pos, piece, iDir))
+                nFour++;
+
+            if (nFour >= 2)
+                return true;
+        }
+        return false;
+    }
+
+    bool isDoubleThree(Pos pos, Color piece)
+    {
+        if (board[pos] != EMPTY || isFive(pos, piece))
+            return false;
+
+        int nThree = 0;
+        for (int iDir = 0; iDir < 4; iDir++) {
+            if (isOpenThree(pos, piece, iDir))
+                nThree++;
+
+            if (nThree >= 2)
+                return true;
+        }
+        return false;
+    }
+};
+
+// Position::transform() as it was before the permutation tables: every stone taken off,
+// then put back on the cell given by its coordinates, so that the key, bitboards and
+// open windows are maintained as by the optimized path. Only the two board scans of
+// the old code are left out. The colours of the history must alternate from black.
+inline void transform_position(Position &pos, TransformType type)
+{
+    const int n = pos.get_move_count();
+    move_t    moves[Position::RealBoardSize * Position::RealBoardSize];
+    memcpy(moves, pos.get_hist_moves(), n * sizeof(move_t));
+
+    while (pos.get_move_count())
+        pos.undo();
+    for (int i = 0; i < n; i++)
+        pos.move((moves[i] & ~0x03FF)
+                 | transform_pos(PosFromMove(moves[i]), pos.get_size(), type));
+}
+
+}  // namespace reference
@@ -0,0 +1,84 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks of Position::threat_features on hand-made positions: straight fours, and fours
+// that only complete an overline. Prints each failed check and exits with status 1.
+// Build from the repository root with:
+//   g++ -std=c++17 -O2 -Icore tools/test_threats.cpp core/position.cpp core/bitboard.cpp
+//       core/pattern.cpp core/codec.cpp core/util.cpp -o test_threats -pthread
+
+#include "position.h"
+#include "util.h"
+
+#include <cstdio>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, GameRule rule)
+{
+    if (!ok) {
+        printf("FAILED (rule %d): %s\n", (int)rule, what);
+        failures++;
+    }
+}
+
+// Black stones on row 7 at the given columns, white ones apart on rows 0 and 14 (far
+// enough from each other to make no pattern)
+static Position make_position(const std::vector<int> &blackColumns)
+{
+    Position pos(15);
+    for (size_t i = 0; i < blackColumns.size(); i++) {
+        pos.move(BLACK << 10 | POS(blackColumns[i], 7));
+        if (i + 1 < blackColumns.size())
+            pos.move(WHITE << 10 | POS(5 * (i % 3), i < 3 ? 0 : 14));
+    }
+    return pos;
+}
+
+int main()
+{
+    for (GameRule rule : ALL_VALID_RULES) {
+        ThreatFeatures features;
+
+        // _ _ X X X _ _: the cells next to the three make a straight four, the ones
+        // after them a four
+        make_position({5, 6, 7}).threat_features(rule, features);
+        check(features.count[BLACK][THREAT_OPEN_FOUR] == 2, "open fours of a three", rule);
+        check(features.has(BLACK, THREAT_OPEN_FOUR, POS(4, 7))
+                  && features.has(BLACK, THREAT_OPEN_FOUR, POS(8, 7)),
+              "open four cells of a three",
+              rule);
+        check(features.count[BLACK][THREAT_FOUR] == 2, "fours of a three", rule);
+
+        // _ X X X X _ on the board: both ends make five
+        make_position({5, 6, 7, 8}).threat_features(rule, features);
+        check(features.count[BLACK][THREAT_FIVE] == 2, "fives of a straight four", rule);
+
+        // X X X _ _ X X from the edge: a stone on column 3 or 4 makes a four whose only
+        // five spot (the other one) completes an overline
+        make_position({0, 1, 2, 5, 6}).threat_features(rule, features);
+        const bool allowLong = rule == GOMOKU_FIVE_OR_MORE;
+        check(features.has(BLACK, THREAT_FOUR, POS(3, 7)) == allowLong
+                  && features.has(BLACK, THREAT_FOUR, POS(4, 7)) == allowLong,
+              "fours completing an overline",
+              rule);
+    }
+
+    if (!failures)
+        printf("all threat checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,651 @@
+/*
+ *  c-gomoku-cli, a command line interface for Gomocup engines. Copyright 2021 Chao Ma.
+ *  c-gomoku-cli is derived from c-chess-cli, originally authored by lucasart 2020.
+ *
+ *  c-gomoku-cli is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ *  c-gomoku-cli is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE. See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this
+ * program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Validation of the game records and sample files written by c-gomoku-cli, without
+// re-running the games: every game (or sample) is replayed through Position and checked
+// for illegal moves, forbidden moves, play after a five, and a result and termination
+// reason that do not match the final position. Files are read as a stream and cut into
+// batches of whole records, which a pool of threads validates, so memory stays bounded
+// whatever the file size. Build from the repository root with:
+//   g++ -std=c++17 -O2 -Icore tools/validate_records.cpp core/position.cpp
+//       core/bitboard.cpp core/pattern.cpp core/codec.cpp core/util.cpp
+//       core/extern/lz4.c core/extern/lz4frame.c core/extern/lz4hc.c
+//       core/extern/xxhash.c -o validate_records -pthread
+// Usage: validate_records [-threads N] [-errors N] [-binpack] file...
+// SGF files are recognized by their content. Other files are bin samples (LZ4 frames
+// are decompressed on the fly), or binpack samples with -binpack.
+
+#include "extern/lz4frame.h"
+#include "position.h"
+#include "util.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+enum Format { FORMAT_SGF, FORMAT_BIN, FORMAT_BINPACK };
+
+static const size_t BatchSize = 1 << 20;  // bytes of records handed to a thread at once
+
+// Entry layouts of Game::export_samples_bin() and Game::export_samples_binpack()
+struct BinHead
+{
+    uint16_t result : 2;
+    uint16_t ply : 9;
+    uint16_t boardsize : 5;
+    uint16_t rule : 3;
+    uint16_t move : 13;
+};
+static_assert(sizeof(BinHead) == 4);
+
+struct BinpackHead
+{
+    uint32_t boardSize : 5;
+    uint32_t rule : 3;
+    uint32_t result : 4;
+    uint32_t totalPly : 10;
+    uint32_t initPly : 10;
+    uint32_t gameTag : 14;
+    uint32_t moveCount : 18;
+};
+static_assert(sizeof(BinpackHead) == 8);
+
+struct BinpackMove
+{
+    uint16_t flags : 6;
+    uint16_t move : 10;
+    int16_t  eval;
+};
+static_assert(sizeof(BinpackMove) == 4);
+
+struct Batch
+{
+    std::string data;         // whole records
+    size_t      firstRecord;  // index of the first one in the file
+    Format      format;
+};
+
+// Batches from the reader to the validating threads. Pushing blocks while the queue is
+// full, which is what bounds the memory.
+class BatchQueue
+{
+public:
+    explicit BatchQueue(size_t cap) : capacity(cap) {}
+
+    void push(Batch &&batch)
+    {
+        std::unique_lock lock(mtx);
+        notFull.wait(lock, [&] { return queue.size() < capacity; });
+        queue.push_back(std::move(batch));
+        notEmpty.notify_one();
+    }
+
+    bool pop(Batch &batch)
+    {
+        std::unique_lock lock(mtx);
+        notEmpty.wait(lock, [&] { return !queue.empty() || closed; });
+        if (queue.empty())
+            return false;
+        batch = std::move(queue.front());
+        queue.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard lock(mtx);
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+private:
+    std::mutex              mtx;
+    std::condition_variable notFull, notEmpty;
+    std::deque<Batch>       queue;
+    size_t                  capacity;
+    bool                    closed = false;
+};
+
+// Reads a file, decompressing it if it is made of LZ4 frames
+class Reader
+{
+public:
+    explicit Reader(const char *fileName)
+    {
+        in = fopen(fileName, "r" FOPEN_BINARY);
+        if (!in)
+            DIE("Could not open '%s'\n", fileName);
+
+        inLen = fread(inBuf, 1, sizeof(inBuf), in);
+        if (inLen >= 4 && !memcmp(inBuf, "\x04\x22\x4d\x18", 4)
+            && LZ4F_isError(LZ4F_createDecompressionContext(&lz4Ctx, LZ4F_VERSION)))
+            DIE("Could not create an LZ4 decompression context\n");
+    }
+
+    ~Reader()
+    {
+        if (lz4Ctx)
+            LZ4F_freeDecompressionContext(lz4Ctx);
+        fclose(in);
+    }
+
+    // appends up to size bytes to out, returns false at the end of the file
+    bool read(std::string &out, size_t size)
+    {
+        const size_t start = out.size();
+        out.resize(start + size);
+        size_t done = 0;
+
+        while (done < size && (inPos < inLen || refill())) {
+            size_t srcLen = inLen - inPos, dstLen = size - done;
+            if (!lz4Ctx) {
+                dstLen = std::min(srcLen, dstLen);
+                memcpy(&out[start + done], inBuf + inPos, dstLen);
+                srcLen = dstLen;
+            }
+            else if (LZ4F_isError(LZ4F_decompress(lz4Ctx,
+                                                  &out[start + done],
+                                                  &dstLen,
+                                                  inBuf + inPos,
+                                                  &srcLen,
+                                                  nullptr)))
+                DIE("Corrupted LZ4 stream\n");
+            inPos += srcLen;
+            done += dstLen;
+        }
+
+        out.resize(start + done);
+        return done > 0;
+    }
+
+private:
+    FILE                       *in;
+    LZ4F_decompressionContext_t lz4Ctx = nullptr;
+    char                        inBuf[1 << 16];
+    size_t                      inLen = 0, inPos = 0;
+
+    bool refill()
+    {
+        inPos = 0;
+        inLen = fread(inBuf, 1, sizeof(inBuf), in);
+        return inLen > 0;
+    }
+};
+
+// Totals of a file, summed over the threads, and the first errors found
+struct Report
+{
+    std::atomic<uint64_t>    records {0}, moves {0}, errors {0};
+    std::mutex               mtx;
+    std::vector<std::string> messages;
+    size_t                   maxMessages = 20;
+
+    void error(size_t record, const std::string &message)
+    {
+        if (errors++ < maxMessages) {
+            std::lock_guard lock(mtx);
+            messages.push_back(format("record %zu: %s", record, message));
+        }
+    }
+};
+
+static bool valid_rule(int rule)
+{
+    return rule == GOMOKU_FIVE_OR_MORE || rule == GOMOKU_EXACT_FIVE || rule == RENJU;
+}
+
+// Plays a move given by its raw coordinates (as in the sample files), checking that it
+// is on the board and on an empty cell
+static bool play_raw(Position &pos, unsigned raw, std::string &error)
+{
+    const int x = raw >> MAX_BOARD_SIZE_BIT, y = raw & ((1 << MAX_BOARD_SIZE_BIT) - 1);
+    if (x >= pos.get_size() || y >= pos.get_size()) {
+        error = format("move %d,%d out of the board", x, y);
+        return false;
+    }
+    const move_t m = pos.get_turn() << 10 | POS(x, y);
+    if (!pos.is_legal_move(m)) {
+        error = format("move %s on an occupied cell", pos.move_to_gomostr(m));
+        return false;
+    }
+    pos.move(m);
+    return true;
+}
+
+// Looks up the value of a property of an SGF record (the first one of that name)
+static std::string_view sgf_property(std::string_view record, std::string_view name)
+{
+    for (size_t i = record.find(name); i != std::string_view::npos;
+         i         = record.find(name, i + 1)) {
+        const size_t open  = i + name.size();
+        const bool   start = i == 0 || record[i - 1] == ';' || record[i - 1] == ']';
+        if (!start || open >= record.size() || record[open] != '[')
+            continue;
+        const size_t close = record.find(']', open);
+        if (close != std::string_view::npos)
+            return record.substr(open + 1, close - open - 1);
+    }
+    return {};
+}
+
+// Replays an SGF game record of Game::export_sgf(). Returns the first inconsistency.
+static std::string check_sgf(std::string_view record, uint64_t &moves)
+{
+    const int  size   = atoi(std::string(sgf_property(record, "SZ")).c_str());
+    const int  rule   = atoi(std::string(sgf_property(record, "RU")).c_str());
+    const auto result = sgf_property(record, "RE");
+    const auto reason = sgf_property(record, "TE");
+
+    if (size < 5 || size > Position::RealBoardSize || !valid_rule(rule))
+        return format("bad board size %d or rule %d", size, rule);
+
+    const RuleKernel &rules = RuleKernel::get(size, (GameRule)rule);
+    Position          pos(size);
+    bool              five = false, opening = true;
+
+    // moves start at the first ";B[" or ";W[" after the header
+    for (size_t i = record.find(';', 1); i != std::string_view::npos;
+         i         = record.find(';', i + 1)) {
+        if (i + 5 >= record.size() || record[i + 2] != '['
+            || (record[i + 1] != 'B' && record[i + 1] != 'W'))
+            continue;
+
+        const Color color = record[i + 1] == 'B' ? BLACK : WHITE;
+        const int   x = record[i + 3] - 'a', y = record[i + 4] - 'a';
+        const bool  isOpening = record.compare(i + 6, 15, "C[opening move]") == 0;
+
+        if (five)
+            return format("moves played after a five, at move %d", pos.get_move_count());
+        if (isOpening && !opening)
+            return format("opening move after played moves, at move %d",
+                          pos.get_move_count());
+        opening = isOpening;
+        if (color != pos.get_turn())
+            return format("colours do not alternate at move %d", pos.get_move_count());
+        if (x < 0 || y < 0 || x >= size || y >= size || record[i + 5] != ']')
+            return format("bad coordinates at move %d", pos.get_move_count());
+
+        const move_t m = color << 10 | POS(x, y);
+        if (!pos.is_legal_move(m))
+            return format("move %s on an occupied cell", pos.move_to_gomostr(m));
+        if (!isOpening && rules.forbidden(pos, m))
+            return format("forbidden move %s played", pos.move_to_gomostr(m));
+        pos.move(m);
+        five = rules.five_lastmove(pos);
+        moves++;
+    }
+
+    // the result and termination reason against the final position
+    const bool forbidden = reason.substr(0, 26) == "Black play forbidden move ";
+    const bool blackWins = reason.substr(0, 9) == "Black win";
+    const bool whiteWins = reason.substr(0, 9) == "White win" || forbidden;
+    const bool draw      = reason.substr(0, 4) == "Draw";
+    const auto expected  = blackWins ? "B+1" : whiteWins ? "W+1" : draw ? "0" : "*";
+    if (result != expected)
+        return format("result %s does not match termination '%s'",
+                      std::string(result),
+                      std::string(reason));
+
+    const Color toMove = pos.get_turn();
+    const Color winner = blackWins ? BLACK : WHITE;
+    if (five != (reason.find("by five connection") != std::string_view::npos))
+        return format("termination '%s' but the last move %s a five",
+                      std::string(reason),
+                      five ? "makes" : "does not make");
+    if (five && winner == toMove)
+        return "five credited to the side to move";
+    if (reason == "Draw by fullfilled board" && pos.get_moves_left())
+        return format("draw by full board with %d empty cells", pos.get_moves_left());
+    if (reason == "Draw by dead position" && !pos.is_dead())
+        return "draw by dead position, but a five can still be made";
+    if (forbidden && toMove != BLACK)
+        return "forbidden move by black, but white is to move";
+
+    // the engine on the move loses on time, crash, illegal move or resign, and wins
+    // by VCF (solved and consensus adjudications can go either way)
+    const bool lossOnMove = reason.find("time forfeit") != std::string_view::npos
+                            || reason.find("opponent") != std::string_view::npos
+                            || reason.find("by adjudication") != std::string_view::npos;
+    if ((blackWins || whiteWins) && lossOnMove && winner == toMove)
+        return format("'%s' credited to the side to move", std::string(reason));
+    if ((blackWins || whiteWins) && reason.find("by VCF") != std::string_view::npos
+        && winner != toMove)
+        return "VCF win credited to the side that just moved";
+
+    return {};
+}
+
+static void validate_sgf(const Batch &batch, Report &report)
+{
+    std::string_view data   = batch.data;
+    size_t           record = batch.firstRecord;
+
+    for (size_t start = data.find("(;"); start != std::string_view::npos; record++) {
+        const size_t end = data.find("\n(;", start);
+        uint64_t     moves = 0;
+        std::string  error = check_sgf(data.substr(start, end - start), moves);
+        if (!error.empty())
+            report.error(record, error);
+        report.records++;
+        report.moves += moves;
+        start = end == std::string_view::npos ? end : end + 1;
+    }
+}
+
+static size_t bin_entry_size(const char *p)
+{
+    BinHead head;
+    memcpy(&head, p, sizeof(head));
+    return sizeof(BinHead) + sizeof(uint16_t) * head.ply;
+}
+
+static size_t binpack_entry_size(const char *p)
+{
+    BinpackHead head;
+    memcpy(&head, p, sizeof(head));
+    return sizeof(BinpackHead) + sizeof(uint16_t) * head.initPly
+           + sizeof(BinpackMove) * head.moveCount;
+}
+
+// The bin entry at q is the position of p, followed by the move of p and maybe more
+// moves: both samples come from the same game
+static bool bin_follows(const char *p, const char *q)
+{
+    BinHead a, b;
+    memcpy(&a, p, sizeof(a));
+    memcpy(&b, q, sizeof(b));
+    if (b.ply <= a.ply || b.boardsize != a.boardsize
+        || memcmp(p + sizeof(BinHead), q + sizeof(BinHead), sizeof(uint16_t) * a.ply))
+        return false;
+
+    // the move and the position are both stored as POS_RAW(x, y)
+    uint16_t next;
+    memcpy(&next, q + sizeof(BinHead) + sizeof(uint16_t) * a.ply, sizeof(next));
+    return next == a.move;
+}
+
+static std::string check_bin(const char *p, const char *previous)
+{
+    BinHead head;
+    memcpy(&head, p, sizeof(head));
+    if (head.boardsize < 5 || head.boardsize > Position::RealBoardSize
+        || !valid_rule(head.rule) || head.result > 2)
+        return format("bad board size %d, rule %d or result %d",
+                      (int)head.boardsize,
+                      (int)head.rule,
+                      (int)head.result);
+
+    const RuleKernel &rules = RuleKernel::get(head.boardsize, (GameRule)head.rule);
+    Position          pos(head.boardsize);
+    std::string       error;
+
+    for (unsigned i = 0; i < head.ply; i++) {
+        uint16_t raw;
+        memcpy(&raw, p + sizeof(BinHead) + sizeof(uint16_t) * i, sizeof(raw));
+        if (!play_raw(pos, raw, error))
+            return error;
+        if (rules.five_lastmove(pos))
+            return format("sampled position has a five at move %u", i + 1);
+    }
+
+    // the sample move is stored as POS_RAW(x, y), without colour: it is played by the
+    // side to move
+    const int    x = head.move >> MAX_BOARD_SIZE_BIT & 31, y = head.move & 31;
+    const move_t m = pos.get_turn() << 10 | POS(x, y);
+    if (x >= head.boardsize || y >= head.boardsize || !pos.is_legal_move(m))
+        return format("illegal sample move %d,%d", x, y);
+    if (rules.forbidden(pos, m))
+        return format("forbidden sample move %s", pos.move_to_gomostr(m));
+
+    // results of samples of the same game, from each side to move's pov
+    if (previous && bin_follows(previous, p)) {
+        BinHead before;
+        memcpy(&before, previous, sizeof(before));
+        const int plies    = head.ply - before.ply;
+        const int expected = plies % 2 ? 2 - before.result : before.result;
+        if (head.result != expected)
+            return format("result %d, %d expected from the previous sample of the game",
+                          (int)head.result,
+                          expected);
+    }
+
+    return {};
+}
+
+static void validate_bin(const Batch &batch, Report &report)
+{
+    const char *p = batch.data.data(), *end = p + batch.data.size(), *previous = nullptr;
+
+    for (size_t record = batch.firstRecord; p < end; record++) {
+        std::string error = check_bin(p, previous);
+        if (!error.empty())
+            report.error(record, error);
+        report.records++;
+        report.moves += (bin_entry_size(p) - sizeof(BinHead)) / sizeof(uint16_t);
+        previous = p;
+        p += bin_entry_size(p);
+    }
+}
+
+static std::string check_binpack(const char *p)
+{
+    BinpackHead head;
+    memcpy(&head, p, sizeof(head));
+    if (head.boardSize < 5 || head.boardSize > Position::RealBoardSize
+        || !valid_rule(head.rule) || head.result > 2
+        || head.totalPly != head.initPly + head.moveCount)
+        return format("bad board size %d, rule %d, result %d or ply count",
+                      (int)head.boardSize,
+                      (int)head.rule,
+                      (int)head.result);
+
+    const RuleKernel &rules = RuleKernel::get(head.boardSize, (GameRule)head.rule);
+    Position          pos(head.boardSize);
+    std::string       error;
+    const char       *moves = p + sizeof(BinpackHead) + sizeof(uint16_t) * head.initPly;
+
+    for (unsigned i = 0; i < head.totalPly; i++) {
+        uint16_t raw;
+        if (i < head.initPly)
+            memcpy(&raw, p + sizeof(BinpackHead) + sizeof(uint16_t) * i, sizeof(raw));
+        else {
+            BinpackMove move;
+            memcpy(&move, moves + sizeof(BinpackMove) * (i - head.initPly), sizeof(move));
+            raw = move.move;
+        }
+
+        if (pos.get_move_count() && rules.five_lastmove(pos))
+            return format("moves played after a five, at move %u", i);
+        if (i >= head.initPly && pos.get_turn() == BLACK) {
+            const int x = raw >> MAX_BOARD_SIZE_BIT, y = raw & 31;
+            if (x < head.boardSize && y < head.boardSize
+                && rules.forbidden(pos, BLACK << 10 | POS(x, y)))
+                return format("forbidden move %d,%d played", x, y);
+        }
+        if (!play_raw(pos, raw, error))
+            return error;
+    }
+
+    return {};
+}
+
+static void validate_binpack(const Batch &batch, Report &report)
+{
+    const char *p = batch.data.data(), *end = p + batch.data.size();
+
+    for (size_t record = batch.firstRecord; p < end; record++) {
+        BinpackHead head;
+        memcpy(&head, p, sizeof(head));
+        std::string error = check_binpack(p);
+        if (!error.empty())
+            report.error(record, error);
+        report.records++;
+        report.moves += head.totalPly;
+        p += binpack_entry_size(p);
+    }
+}
+
+// Cuts the stream into batches of whole records. Returns the bytes read.
+static uint64_t read_batches(const char *fileName,
+                             bool        binpack,
+                             BatchQueue &queue,
+                             Report     &report,
+                             Format     &fileFormat)
+{
+    Reader      reader(fileName);
+    std::string pending;
+    size_t      record = 0;
+    uint64_t    bytes  = 0;
+
+    pending.reserve(2 * BatchSize);
+    bool         more  = reader.read(pending, BatchSize);
+    const size_t first = pending.find_first_not_of(" \t\r\n");
+    const Format type  = first != std::string::npos && pending[first] == '(' ? FORMAT_SGF
+                         : binpack ? FORMAT_BINPACK
+                                   : FORMAT_BIN;
+    fileFormat         = type;
+
+    while (!pending.empty()) {
+        // end of the last whole record in pending, and their count
+        size_t cut = 0, count = 0;
+
+        if (type == FORMAT_SGF) {
+            cut = more ? pending.rfind("\n(;") : pending.size();
+            cut = cut == std::string::npos ? 0 : cut + !!more;
+            for (size_t i = pending.find("(;"); i < cut; i = pending.find("(;", i + 2))
+                count++;
+        }
+        else {
+            // bin batches end between games when possible, for the result checks
+            const bool   bin       = type == FORMAT_BIN;
+            const auto   entrySize = bin ? bin_entry_size : binpack_entry_size;
+            const size_t headSize  = bin ? sizeof(BinHead) : sizeof(BinpackHead);
+            size_t last = std::string::npos;
+
+            while (cut + headSize <= pending.size()
+                   && cut + entrySize(&pending[cut]) <= pending.size()) {
+                if (bin && cut >= BatchSize && last != std::string::npos
+                    && !bin_follows(&pending[last], &pending[cut]))
+                    break;
+                if (cut >= 2 * BatchSize)
+                    break;
+                last = cut;
+                cut += entrySize(&pending[cut]);
+                count++;
+            }
+            if (!more && !cut && !pending.empty()) {
+                report.error(record,
+                             format("truncated record at byte %llu",
+                                    (unsigned long long)bytes));
+                break;
+            }
+        }
+
+        if (cut && (cut >= BatchSize || !more)) {
+            queue.push(Batch {pending.substr(0, cut), record, type});
+            pending.erase(0, cut);
+            bytes += cut;
+            record += count;
+        }
+        else if (!more)
+            break;
+        else
+            more = reader.read(pending, BatchSize);
+    }
+
+    return bytes;
+}
+
+int main(int argc, char **argv)
+{
+    int                       threads   = std::thread::hardware_concurrency();
+    size_t                    maxErrors = 20;
+    bool                      binpack   = false;
+    std::vector<const char *> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-threads") && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-errors") && i + 1 < argc)
+            maxErrors = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-binpack"))
+            binpack = true;
+        else if (argv[i][0] == '-')
+            DIE("Unknown option '%s'\n", argv[i]);
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty())
+        DIE("Usage: validate_records [-threads N] [-errors N] [-binpack] file...\n");
+    threads = std::max(threads, 1);
+
+    const char *FormatName[] = {"sgf", "bin", "binpack"};
+    uint64_t    totalErrors  = 0;
+
+    for (const char *fileName : files) {
+        const auto               start = Clock::now();
+        BatchQueue               queue(2 * threads);
+        Report                   report;
+        std::vector<std::thread> pool;
+
+        report.maxMessages = maxErrors;
+        for (int t = 0; t < threads; t++)
+            pool.emplace_back([&] {
+                Batch batch;
+                while (queue.pop(batch)) {
+                    if (batch.format == FORMAT_SGF)
+                        validate_sgf(batch, report);
+                    else if (batch.format == FORMAT_BIN)
+                        validate_bin(batch, report);
+                    else
+                        validate_binpack(batch, report);
+                }
+            });
+
+        Format         format;
+        const uint64_t bytes = read_batches(fileName, binpack, queue, report, format);
+        queue.close();
+        for (std::thread &t : pool)
+            t.join();
+        const double sec = std::chrono::duration<double>(Clock::now() - start).count();
+
+        for (const std::string &message : report.messages)
+            printf("%s: %s\n", fileName, message.c_str());
+        printf("%s (%s): %llu records, %llu moves, %llu errors | %.1f MB/s, "
+               "%.0f records/s\n",
+               fileName,
+               FormatName[format],
+               (unsigned long long)report.records,
+               (unsigned long long)report.moves,
+               (unsigned long long)report.errors,
+               bytes / sec / 1e6,
+               report.records / sec);
+        totalErrors += report.errors;
+    }
+
+    return totalErrors ? 1 : 0;
+}